@@ -1,14 +1,76 @@
 
 #include "ast.h"
 #include "value.h"
+#include "reduce.h"
+#include "function.h"
+#include "range.h"
+#include "builtin.h"
+#include "number.h"
+#include "profile.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <math.h>
+
 /****************************************************************************/
 
-void AST_print_verbose_r_(AST_Node root);
-void AST_print_r(AST_Node root);
+void AST_print_verbose_r_(AST_Node root, Env e, FILE *out);
+void AST_print_r(AST_Node root, Env e, FILE *out);
+
+static Value AST_evaluate_r(AST_Node root, CalcContext ctx, bool show_errors,
+                            bool *complete, bool *owned);
+static Value AST_evaluate_node(AST_Node root, CalcContext ctx,
+                               bool show_errors, bool *complete, bool *owned);
+static void  bind_lazily(AST_Node leaf, CalcContext ctx);
+static Value counted(Value v, CalcContext ctx);
+static bool  decides(AST_Node root, Value lhs);
+static Value operate(AST_Node root, OPERATOR op, Value vl, Value vr,
+                     CalcContext ctx, bool show_errors);
+static bool  branch(AST_Node root, CalcContext ctx, bool show_errors,
+                    bool *complete, AST_Node *taken);
+static Value evaluate_conditional(AST_Node root, CalcContext ctx,
+                                  bool show_errors, bool *complete,
+                                  bool *owned);
+static Value evaluate_call(AST_Node root, CalcContext ctx, bool show_errors,
+                           bool *complete, bool *owned);
+static Function called(AST_Node root, CalcContext ctx, bool show_errors,
+                       bool *complete, Value *result);
+static Value product(AST_Node root, Value f, CalcContext ctx,
+                     bool show_errors, bool *complete);
+static bool  arguments(AST_Node root, Function fn, Value *args,
+                       CalcContext ctx, bool show_errors, bool *complete);
+static AST_Node tail_position(AST_Node root, CalcContext ctx,
+                              bool show_errors, bool *complete);
+static Value evaluate_builtin(AST_Node root, CalcContext ctx,
+                              bool show_errors, bool *complete, bool *owned);
+static Value evaluate_range(AST_Node root, CalcContext ctx, bool show_errors,
+                            bool *complete, bool *owned);
+static bool  range_term(void *arg, CalcContext ctx, int64_t i,
+                        bool show_errors, bool *complete, Value *term);
+static bool  bound(AST_Node root, const char *name, CalcContext ctx,
+                   bool show_errors, bool *complete, int64_t *i);
+static bool  self_contained(AST_Node root, unsigned depth);
+static bool  is_call(AST_Node root);
+static bool  is_applied(AST_Node root);
+static const char *callee(AST_Node root);
+static bool  arguments_formed(AST_Node root);
+static Value shown(AST_Node root, Env e);
+static void  print_number(double x, FILE *out);
+
+static OPERATOR precedence(AST_Node n);
+
+/* The term of a range, and the name of its reduction */
+typedef struct Term {
+    AST_Node body;
+    const char *name;
+} Term;
+
+static const Value ILL_TYPED = {INVALID, false, {0}};
+
+/* Calls nest no deeper, so that runaway recursion is reported rather */
+/* than overflowing the C stack                                      */
+static const unsigned MAX_FRAMES = 5000;
 
 /****************************************************************************/
 
@@ -22,6 +84,10 @@ AST_Node AST_new()
     n->left = NULL;
     n->right = NULL;
     n->v = NOTHING;
+    n->kernel = GENERAL;
+    n->k = 0;
+    n->refs = 1;
+    n->shared = 0;
 
     return n;
 }
@@ -37,6 +103,10 @@ AST_Node AST_newv(Value v)
     n->left = NULL;
     n->right = NULL;
     n->v = v;
+    n->kernel = GENERAL;
+    n->k = 0;
+    n->refs = 1;
+    n->shared = 0;
 
     return n;
 }
@@ -46,6 +116,8 @@ AST_Node AST_copy(AST_Node root)
     if (root == NULL) return NULL;
     
     AST_Node n = AST_newv(Value_copy(root->v));
+    n->kernel = root->kernel;
+    n->k = root->k;
     n->left = AST_copy(root->left);
     n->right = AST_copy(root->right);
 
@@ -55,10 +127,15 @@ AST_Node AST_copy(AST_Node root)
 void AST_free(AST_Node *root)
 {
     if (root == NULL || *root == NULL) return;
-    AST_free(&(*root)->left);
-    AST_free(&(*root)->right);
-    Value_free(&(*root)->v);
-    free(*root);
+
+    // A shared node goes with the last of its parents
+    if (--(*root)->refs == 0) {
+        AST_free(&(*root)->left);
+        AST_free(&(*root)->right);
+        Value_free(&(*root)->v);
+        free(*root);
+    }
+    *root = NULL;
 }
 
 AST_Node AST_insert(Value v, AST_Node root)
@@ -70,11 +147,17 @@ AST_Node AST_insert(Value v, AST_Node root)
 
     switch (v.type) {
         case VAR:
+        case LOCAL:
         case BOOL:
         case STRING:
+        case FUNCTION:
+        case BUILTIN:
         case NUMBER: return AST_insertleaf(new_n, root);
         case OP:
-            if (v.u.op == PAREN) return AST_insertleaf(new_n, root);
+            if ((v.u.op == PAREN) || (v.u.op == COND) ||
+                    (v.u.op == CALL) || (v.u.op == RANGE)) {
+                return AST_insertleaf(new_n, root);
+            }
             else return AST_insertoperator(new_n, root);
         case RELAT_OP:
             return AST_insertoperator(new_n, root);
@@ -120,258 +203,911 @@ AST_Node AST_insertoperator(AST_Node n, AST_Node root)
     return root;
 }
 
-void AST_print(AST_Node root)
+void AST_print(AST_Node root, Env e, FILE *out)
 {
-    AST_print_r(root);
-    fputc('\n', stdout);
+    AST_print_r(root, e, out);
+    fputc('\n', out);
 }
 
-void AST_print_r(AST_Node root)
+void AST_print_r(AST_Node root, Env e, FILE *out)
 {
     if (root == NULL) { 
         return;
     }
 
-    AST_print_r(root->left);
+    // The branches print themselves around their else
+    if ((root->v.type == OP) && (root->v.u.op == COND)) {
+        fprintf(out, "if ");
+        AST_print_r(root->left, e, out);
+        fprintf(out, "then ");
+        AST_print_r(root->right, e, out);
+        return;
+    }
+    if (is_applied(root)) {
+        // A name bound to anything but a function multiplies
+        if (shown(root->left, e).type != root->left->v.type) {
+            AST_print_r(root->left, e, out);
+            fprintf(out, "%s ( ", OPERATORtosymbol(PROD));
+        } else fprintf(out, "%s ( ", callee(root));
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            if (arg != root->right) fprintf(out, ", ");
+            AST_print_r(arg->left, e, out);
+        }
+        fprintf(out, ") ");
+        return;
+    }
+
+    AST_print_r(root->left, e, out);
 
-    switch (root->v.type) {
+    Value v = shown(root, e);
+    switch (v.type) {
         case NONE:      return;
         case INVALID:   return;
         case NUMBER:
-            fprintf(stdout, "%.15g ", root->v.u.d);
+            print_number(Value_number(v), out);
+            fputc(' ', out);
             break;
         case STRING:
-            fputc('\"', stdout);
-            print_string(root->v.u.s, stdout);
-            fputc('\"', stdout);
+            fputc('\"', out);
+            print_string(v.u.s, out);
+            fputc('\"', out);
             break;
         case BOOL:
-            fprintf(stdout, "%s ", root->v.u.b ? "<True>" : "<False>");
+            fprintf(out, "%s ", v.u.b ? "<True>" : "<False>");
             break;
         case RELAT_OP:
-            fprintf(stdout, "%s ", RELOPtostring(root->v.u.rop));
+            fprintf(out, "%s ", RELOPtostring(root->v.u.rop));
             break;
         case OP:
             if (root->v.u.op != PAREN) {
-                fprintf(stdout, "%c ", OPERATORtochar(root->v.u.op));
+                fprintf(out, "%s ", OPERATORtosymbol(root->v.u.op));
             } else {
-                fprintf(stdout, "( ");
-                AST_print_r(root->right);
-                fprintf(stdout, ") ");
+                fprintf(out, "( ");
+                AST_print_r(root->right, e, out);
+                fprintf(out, ") ");
                 return;
             }
             break;
-        case VAR: 
-            fprintf(stderr, "%s [Line %d]: "
-                            "(Argh! You've found an interpreter bug!)",
-                            FILENAME, LINE_NUMBER);
+        case VAR:
+            fprintf(out, "%s ", root->v.u.name);
+            break;
+        case LOCAL:
+            fprintf(out, "%s ", root->v.u.local->name);
+            break;
+        case FUNCTION:
+            Function_print(root->v.u.fn, out);
+            fputc(' ', out);
+            break;
+        case BUILTIN:
+            fprintf(out, "%s ", root->v.u.builtin->name);
             break;
     }
 
-    AST_print_r(root->right);
+    AST_print_r(root->right, e, out);
 }
 
-void AST_print_verbose(AST_Node root)
+void AST_print_verbose(AST_Node root, Env e, FILE *out)
 {
-    AST_print_verbose_r_(root);
-    fputc('\n', stdout);
+    AST_print_verbose_r_(root, e, out);
+    fputc('\n', out);
 }
 
-void AST_print_verbose_r_(AST_Node root)
+void AST_print_verbose_r_(AST_Node root, Env e, FILE *out)
 {
     if (root == NULL) return;
 
-    fprintf(stdout, "(");
+    if ((root->v.type == OP) && (root->v.u.op == COND)) {
+        fprintf(out, "(if ");
+        AST_print_verbose_r_(root->left, e, out);
+        fprintf(out, " then ");
+        if (root->right != NULL) {
+            AST_print_verbose_r_(root->right->left, e, out);
+            fprintf(out, " else ");
+            AST_print_verbose_r_(root->right->right, e, out);
+        }
+        fprintf(out, ")");
+        return;
+    }
+    if (is_applied(root)) {
+        if (shown(root->left, e).type != root->left->v.type) {
+            fprintf(out, "(");
+            AST_print_verbose_r_(root->left, e, out);
+            fprintf(out, " %s (", OPERATORtosymbol(PROD));
+        } else fprintf(out, "(%s(", callee(root));
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            if (arg != root->right) fprintf(out, ", ");
+            AST_print_verbose_r_(arg->left, e, out);
+        }
+        fprintf(out, "))");
+        return;
+    }
 
-    AST_print_verbose_r_(root->left);
-    switch (root->v.type) {
+    fprintf(out, "(");
+
+    AST_print_verbose_r_(root->left, e, out);
+    Value v = shown(root, e);
+    switch (v.type) {
         case NONE:      return;
         case INVALID:   return;
         case NUMBER:
-            fprintf(stdout, "%.15g", root->v.u.d);
+            print_number(Value_number(v), out);
             break;
         case STRING:
-            fputc('\"', stdout);
-            print_string(root->v.u.s, stdout);
-            fputc('\"', stdout);
+            fputc('\"', out);
+            print_string(v.u.s, out);
+            fputc('\"', out);
             break;
         case BOOL:
-            fprintf(stdout, "%s", root->v.u.b ? "<True>" : "<False>");
+            fprintf(out, "%s", v.u.b ? "<True>" : "<False>");
             break;
         case RELAT_OP:
-            fprintf(stdout, " %s ", RELOPtostring(root->v.u.rop));
+            fprintf(out, " %s ", RELOPtostring(root->v.u.rop));
             break;
         case OP:
             if (root->v.u.op != PAREN) {
-                fprintf(stdout, " %c ", OPERATORtochar(root->v.u.op));
+                fprintf(out, " %s ", OPERATORtosymbol(root->v.u.op));
             } else {
-                AST_print_verbose_r_(root->right);
-                fprintf(stdout, ")");
+                AST_print_verbose_r_(root->right, e, out);
+                fprintf(out, ")");
                 return;
             }
             break;
         case VAR:
-            fprintf(stderr, "%s [Line %d]: "
-                            "(Argh! You've found an interpreter bug!)",
-                            FILENAME, LINE_NUMBER);
+            fprintf(out, "%s", root->v.u.name);
+            break;
+        case LOCAL:
+            fprintf(out, "%s", root->v.u.local->name);
+            break;
+        case FUNCTION:
+            Function_print(root->v.u.fn, out);
+            break;
+        case BUILTIN:
+            fprintf(out, "%s", root->v.u.builtin->name);
             break;
     }
-    AST_print_verbose_r_(root->right);
+    AST_print_verbose_r_(root->right, e, out);
 
-    fprintf(stdout, ")");
+    fprintf(out, ")");
 }
 
-void AST_replace_vars(AST_Node root, Env e)
+Value AST_evaluate(AST_Node root, CalcContext ctx, bool show_errors,
+                   bool *complete)
 {
-    if (root == NULL) return;
+    bool dummy;
+    if (complete == NULL) complete = &dummy;
+    *complete = true;
 
-    if (root->v.type == VAR) {
-        Value v = Env_find(e, root->v.u.name);
-        if (v.type != NONE) {
-            Value_free(&(root->v));
-            root->v = Value_copy(v);
-        }
+    // Memos from earlier calls are stale
+    ++ctx->generation;
+
+    bool owned = false;
+    Value v = AST_evaluate_r(root, ctx, show_errors, complete, &owned);
+    ctx->unwinding = false;
+    return owned ? v : counted(Value_copy(v), ctx);
+}
+
+/* Literals and variables are borrowed from the tree and the environment
+ * rather than copied, as are memoized values of shared operators; *owned
+ * tells the caller whether to free the result */
+Value AST_evaluate_r(AST_Node root, CalcContext ctx, bool show_errors,
+                     bool *complete, bool *owned)
+{
+    if ((root == NULL) || (root->shared == 0)) {
+        return AST_evaluate_node(root, ctx, show_errors, complete, owned);
     }
 
-    AST_replace_vars(root->left, e);
-    AST_replace_vars(root->right, e);
+    Memo *m = Context_memo(ctx, root->shared);
+    if (m->generation == ctx->generation) {
+        if (!m->complete) *complete = false;
+        *owned = false;
+        return m->v;
+    }
+
+    bool whole = true;
+    Value v = AST_evaluate_node(root, ctx, show_errors, &whole, owned);
+    if (!whole) *complete = false;
+
+    // Only successes are kept, since failures have diagnostics to repeat.
+    // The table may have grown while the operands were evaluated
+    if (*owned && (v.type != NONE) && (v.type != INVALID)) {
+        m = Context_memo(ctx, root->shared);
+        Value_free(&m->v);
+        m->v = v;
+        m->complete = whole;
+        m->generation = ctx->generation;
+        *owned = false;
+    }
+    return v;
 }
 
-bool AST_validate(AST_Node root)
+/* Bind the slot of a where clause that leaf reads, the first time it is
+ * read. Its expression is evaluated quietly, as part of the evaluation doing
+ * the reading, with the frame entered as the innermost one, since the read
+ * may come from a range's frame inside it. A slot read again while that is
+ * under way is caught in a cycle, and reads as unbound, as does one whose
+ * expression fails */
+void bind_lazily(AST_Node leaf, CalcContext ctx)
 {
-    if (root == NULL) return false;
+    unsigned depth = leaf->v.u.local->depth;
+    unsigned slot = leaf->v.u.local->slot;
+    SlotState *state = Stack_state(ctx->stack, depth, slot);
+    if (*state == IN_PROGRESS) return;
+    *state = IN_PROGRESS;
 
-    switch (root->v.type) {
-        case NONE:      return false;
-        case INVALID:   return false;
-        case VAR:
-            fprintf(stderr, "%s [Line %d]: Runtime error: Name [%s] not "
-                            "bound\n", FILENAME, LINE_NUMBER,
-                            root->v.u.name);
-            return true;
-        case BOOL:
-            return (root->left == NULL) && (root->right == NULL);            
-        case NUMBER:
-            return (root->left == NULL) && (root->right == NULL);            
-        case STRING:
-            return (root->left == NULL) && (root->right == NULL);            
-        case RELAT_OP:
-            return AST_validate(root->left) && AST_validate(root->right);
-        case OP:
-            if (root->v.u.op != PAREN) {
-                if ((root->left == NULL) || (root->right == NULL)) {
-                    fprintf(stderr, "%s [Line %d]: Runtime error: Operator "
-                                    "[%c] expects two arguments\n",
-                                    FILENAME, LINE_NUMBER,
-                                    OPERATORtochar(root->v.u.op));
-                }
-                return AST_validate(root->left) && AST_validate(root->right);
-            } else {
-                if (root->right == NULL) {
-                    fprintf(stderr, "%s [Line %d]: Runtime error: Parentheses "
-                                    "must not be empty\n",
-                                    FILENAME, LINE_NUMBER);
-                }
-                return AST_validate(root->right);
-            }
+    unsigned entered = Stack_enter(ctx->stack, depth);
+    bool complete = true;
+    bool owned;
+    if (ctx->profile != NULL) {
+        char name[64];
+        snprintf(name, sizeof(name), "where %s", leaf->v.u.local->name);
+        Profile_enter(ctx->profile, name);
     }
-    // Compiler dummy
-    return true;
+    Value v = AST_evaluate_r(Stack_thunk(ctx->stack, 0, slot), ctx,
+                             false, &complete, &owned);
+    if (ctx->profile != NULL) Profile_leave(ctx->profile);
+    if ((v.type != NONE) && (v.type != INVALID)) {
+        *Stack_slot(ctx->stack, 0, slot) = owned ? v
+                                                 : counted(Value_copy(v), ctx);
+    } else if (owned) {
+        Value_free(&v);
+    }
+    *Stack_state(ctx->stack, 0, slot) = BOUND;
+    Stack_leave(ctx->stack, entered);
 }
 
-Type AST_typeof(AST_Node root, Env e, bool show_errors)
+/* v, counted towards the profile, if there is one, should it hold memory */
+/* of its own                                                             */
+Value counted(Value v, CalcContext ctx)
 {
+    if ((v.type == STRING) || (v.type == VAR) || (v.type == LOCAL)) {
+        Context_allocated(ctx, 1);
+    }
+    return v;
+}
+
+Value AST_evaluate_node(AST_Node root, CalcContext ctx, bool show_errors,
+                        bool *complete, bool *owned)
+{
+    *owned = false;
     if (root == NULL) {
-        return NONE;
+        *complete = false;
+        return NOTHING;
     }
+    if (ctx->profile != NULL) Profile_node(ctx->profile);
 
-    Value lhs = NOTHING;
-    Value rhs = NOTHING;
+    Value vl;
+    Value vr;
+    bool lowned;
+    bool rowned;
+    Value result;
 
     switch (root->v.type) {
         case NONE:
         case INVALID:
-            return root->v.type;
+            *complete = false;
+            return root->v;
         case VAR:
-            lhs = Env_find(e, root->v.u.name);
-            return ((root->left != NULL) || (root->right != NULL)) ?
-                INVALID : lhs.type;
+            vl = Env_find(ctx->env, root->v.u.name);
+            if (vl.type == NONE) {
+                if (show_errors) {
+                    Context_error(ctx, "Runtime error: Name [%s] not "
+                                       "bound\n", root->v.u.name);
+                }
+                return ((root->left != NULL) || (root->right != NULL)) ?
+                    ILL_TYPED : NOTHING;
+            }
+            if ((root->left != NULL) || (root->right != NULL)) {
+                *complete = false;
+                return ILL_TYPED;
+            }
+            return vl;
+        case LOCAL:
+            if (*Stack_state(ctx->stack, root->v.u.local->depth,
+                             root->v.u.local->slot) != BOUND) {
+                bind_lazily(root, ctx);
+            }
+            vl = *Stack_slot(ctx->stack, root->v.u.local->depth,
+                             root->v.u.local->slot);
+            if (vl.type == NONE) {
+                if (show_errors) {
+                    Context_error(ctx, "Runtime error: Name [%s] not "
+                                       "bound\n", root->v.u.local->name);
+                }
+                return ((root->left != NULL) || (root->right != NULL)) ?
+                    ILL_TYPED : NOTHING;
+            }
+            if ((root->left != NULL) || (root->right != NULL)) {
+                *complete = false;
+                return ILL_TYPED;
+            }
+            return vl;
         case NUMBER:
         case BOOL:
         case STRING:
+        case FUNCTION:
+        case BUILTIN:
             if ((root->left != NULL) || (root->right != NULL)) {
-                return INVALID;
-            } else return root->v.type;
-            break;
+                *complete = false;
+                return ILL_TYPED;
+            }
+            return root->v;
         case RELAT_OP:
-            lhs.type = AST_typeof(root->left, e, show_errors);
-            rhs.type = AST_typeof(root->right, e, show_errors);
-            if (lhs.type != rhs.type) {
-                fprintf(stderr, "%s [Line %d]: Type mismatch: Relational "
-                                "operator [%s] cannot operate on arguments "
-                                "of type [%s] and [%s]\n", FILENAME,
-                                LINE_NUMBER, RELOPtostring(root->v.u.rop),
-                                typestring(lhs.type), typestring(rhs.type));
-                return INVALID;
-            } else return ((rhs.type == NUMBER) || (rhs.type == STRING)
-                            || (rhs.type == BOOL)) ?
-                            BOOL : INVALID;
+            vl = AST_evaluate_r(root->left, ctx, show_errors, complete,
+                                &lowned);
+            vr = AST_evaluate_r(root->right, ctx, show_errors, complete,
+                                &rowned);
+            if (vl.type != vr.type) {
+                if (show_errors) {
+                    Context_error(ctx, "Type mismatch: Relational operator "
+                                       "[%s] cannot operate on arguments of "
+                                       "type [%s] and [%s]\n",
+                                       RELOPtostring(root->v.u.rop),
+                                       typestring(vl.type),
+                                       typestring(vr.type));
+                }
+                result = ILL_TYPED;
+            } else if ((vl.type == NUMBER) || (vl.type == STRING) ||
+                       (vl.type == BOOL)) {
+                result = Value_relate(vl, root->v.u.rop, vr);
+            } else result = ILL_TYPED;
+            if (lowned) Value_free(&vl);
+            if (rowned) Value_free(&vr);
+            *owned = true;
+            return result;
         case OP:
-            if (root->v.u.op != PAREN) {
-                lhs.type = AST_typeof(root->left, e, show_errors);
-                rhs.type = AST_typeof(root->right, e, show_errors);
-
-                if (lhs.type != rhs.type) {
-                    if (show_errors) {
-                        fprintf(stderr, "%s [Line %d]: "
-                                        "Type mismatch: Operator [%c] cannot "
-                                        "operate on arguments of type [%s] and "
-                                        "[%s]\n", FILENAME, LINE_NUMBER,
-                                        OPERATORtochar(root->v.u.op),
-                                        typestring(lhs.type),
-                                        typestring(rhs.type));
-                    }
-                    return INVALID;
+            if (root->v.u.op == COND) {
+                return evaluate_conditional(root, ctx, show_errors, complete,
+                                            owned);
+            }
+            if (root->v.u.op == CALL) {
+                if (root->left->v.type == BUILTIN) {
+                    return evaluate_builtin(root, ctx, show_errors, complete,
+                                            owned);
                 }
-                if (root->v.u.op != SUM) {
-                    return (lhs.type == NUMBER) ? NUMBER : INVALID;
-                } else return lhs.type;
-            } else {
-                return AST_typeof(root->right, e, show_errors);
+                return evaluate_call(root, ctx, show_errors, complete, owned);
+            }
+            if (root->v.u.op == RANGE) {
+                return evaluate_range(root, ctx, show_errors, complete,
+                                      owned);
+            }
+            if (root->v.u.op == ARG) {
+                *complete = false;
+                return ILL_TYPED;
             }
+            if (root->v.u.op == PAREN) {
+                if ((root->right == NULL) && show_errors) {
+                    Context_error(ctx, "Runtime error: Parentheses must not "
+                                       "be empty\n");
+                }
+                return AST_evaluate_r(root->right, ctx, show_errors,
+                                      complete, owned);
+            }
+
+            if (((root->left == NULL) || (root->right == NULL)) &&
+                    show_errors) {
+                Context_error(ctx, "Runtime error: Operator [%s] expects two "
+                                   "arguments\n",
+                                   OPERATORtosymbol(root->v.u.op));
+            }
+            vl = AST_evaluate_r(root->left, ctx, show_errors, complete,
+                                &lowned);
+            if ((root->right != NULL) && decides(root, vl)) {
+                *owned = lowned;
+                return vl;
+            }
+            vr = AST_evaluate_r(root->right, ctx, show_errors, complete,
+                                &rowned);
+            result = operate(root, root->v.u.op, vl, vr, ctx, show_errors);
+            if (lowned) Value_free(&vl);
+            if (rowned) Value_free(&vr);
+            *owned = true;
+            return result;
+    }
+    // Compiler dummy
+    return NOTHING;
+}
+
+/* vl op vr, once both are evaluated, by way of root's kernel if op is */
+/* root's own operator                                                 */
+Value operate(AST_Node root, OPERATOR op, Value vl, Value vr,
+              CalcContext ctx, bool show_errors)
+{
+    if (vl.type != vr.type) {
+        if (show_errors) {
+            Context_error(ctx, "Type mismatch: Operator [%s] cannot operate "
+                               "on arguments of type [%s] and [%s]\n",
+                               OPERATORtosymbol(op), typestring(vl.type),
+                               typestring(vr.type));
+        }
+        return ILL_TYPED;
+    }
+    if (isLogical(op)) {
+        return (vl.type == BOOL) ? Value_combine(vl, op, vr) : ILL_TYPED;
     }
-    return root->v.type;
+    if ((vl.type == NUMBER) || ((vl.type == STRING) && (op == SUM))) {
+        Value v = (op == root->v.u.op) ? Reduce_combine(root, vl, vr)
+                                       : Value_combine(vl, op, vr);
+        return counted(v, ctx);
+    }
+    if ((vl.type == NONE) && (op == SUM)) return NOTHING;
+    return ILL_TYPED;
 }
 
-Value AST_eval(AST_Node root)
+/* Only the branch the condition selects is evaluated, so the other may */
+/* have any type, or none                                               */
+Value evaluate_conditional(AST_Node root, CalcContext ctx, bool show_errors,
+                           bool *complete, bool *owned)
 {
-    if (root == NULL) return NOTHING;
+    *owned = false;
+    AST_Node taken;
+    if (!branch(root, ctx, show_errors, complete, &taken)) return ILL_TYPED;
+    return AST_evaluate_r(taken, ctx, show_errors, complete, owned);
+}
 
-    Value vl;
-    Value vr;
-    Value result;
+/* The branch of a conditional its condition selects. False, once       */
+/* reported, if the condition is not a boolean or the branches are missing */
+bool branch(AST_Node root, CalcContext ctx, bool show_errors, bool *complete,
+            AST_Node *taken)
+{
+    if ((root->left == NULL) || (root->right == NULL)) {
+        if (show_errors) {
+            Context_error(ctx, "Runtime error: [if] expects a condition and "
+                               "two branches\n");
+        }
+        *complete = false;
+        return false;
+    }
 
-    if ((root->v.type == OP)) {
-        if (root->v.u.op != PAREN) {
-            vl = AST_eval(root->left);
-            vr = AST_eval(root->right);
-            result = Value_combine(vl, root->v.u.op, vr);
-            Value_free(&vl);
-            Value_free(&vr);
-            return result;
-        } else {
-            return AST_eval(root->right);
+    bool cowned;
+    Value c = AST_evaluate_r(root->left, ctx, show_errors, complete, &cowned);
+    if (c.type != BOOL) {
+        if (show_errors) {
+            Context_error(ctx, "Type mismatch: Condition of [if] must be of "
+                               "type [%s], not [%s]\n", typestring(BOOL),
+                               typestring(c.type));
+        }
+        if (cowned) Value_free(&c);
+        return false;
+    }
+
+    *taken = c.u.b ? root->right->left : root->right->right;
+    if (cowned) Value_free(&c);
+    return true;
+}
+
+/* The arguments are evaluated in the caller's frames, then moved into a */
+/* frame of the callee's. A call in tail position, whose value is the    */
+/* caller's (see tail_position), replaces the caller's frames rather     */
+/* than nesting inside them, unless the caller has a result to remember  */
+Value evaluate_call(AST_Node root, CalcContext ctx, bool show_errors,
+                    bool *complete, bool *owned)
+{
+    Function fn = NULL;
+    unsigned frames = 0;
+    Value result = ILL_TYPED;
+
+    for (;;) {
+        Function next = called(root, ctx, show_errors, complete, &result);
+        if (next == NULL) break;
+
+        unsigned n = Function_arity(next);
+        Value args[n];
+        if (!arguments(root, next, args, ctx, show_errors, complete)) {
+            Function_free(&next);
+            break;
+        }
+
+        for (; frames > 0; --frames) Stack_pop(ctx->stack);
+        // A tail call takes the place of its caller in the profile too
+        if ((ctx->profile != NULL) && (fn != NULL)) {
+            Profile_leave(ctx->profile);
+        }
+        Function_free(&fn);
+        fn = next;
+        if (ctx->profile != NULL) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s()", fn->name);
+            Profile_enter(ctx->profile, name);
+        }
+
+        Value *memo = fn->memo ? Function_recall(fn, args) : NULL;
+        if ((memo != NULL) || (Stack_depth(ctx->stack) >= MAX_FRAMES)) {
+            if (memo != NULL) result = counted(Value_copy(*memo), ctx);
+            else {
+                if (show_errors) {
+                    Context_error(ctx, "Runtime error: Calls nested too "
+                                       "deeply in [%s]\n", fn->name);
+                }
+                ctx->unwinding = true;
+            }
+            for (unsigned i = 0; i < n; ++i) Value_free(&args[i]);
+            break;
+        }
+
+        Context_allocated(ctx, Stack_push(ctx->stack, n));
+        for (unsigned i = 0; i < n; ++i) {
+            *Stack_slot(ctx->stack, 0, i) = args[i];
+        }
+        ++frames;
+        if (fn->where != NULL) {
+            Scope_push(fn->where, ctx);
+            ++frames;
+        }
+
+        AST_Node body = tail_position(fn->body, ctx, show_errors, complete);
+        if (body == NULL) break;
+        if (is_call(body) && !fn->memo) {
+            root = body;
+            continue;
+        }
+
+        bool rowned;
+        result = AST_evaluate_r(body, ctx, show_errors, complete, &rowned);
+        if (!rowned) result = counted(Value_copy(result), ctx);
+        if (fn->memo && (result.type != NONE) && (result.type != INVALID)) {
+            Context_allocated(ctx, Function_remember(fn,
+                                       Stack_slot(ctx->stack, frames - 1, 0),
+                                       result));
         }
-    } else if (root->v.type == RELAT_OP) {
-        vl = AST_eval(root->left);
-        vr = AST_eval(root->right);
-        result = Value_relate(vl, root->v.u.rop, vr);
-        Value_free(&vl);
-        Value_free(&vr);
-        return result;
+        break;
+    }
+
+    for (; frames > 0; --frames) Stack_pop(ctx->stack);
+    if ((ctx->profile != NULL) && (fn != NULL)) Profile_leave(ctx->profile);
+    Function_free(&fn);
+    *owned = true;
+    return result;
+}
+
+/* The function root calls, with a hold on it for the caller to let go */
+/* of. NULL if the name is bound to anything else, which makes root a   */
+/* product after all, left in *result                                   */
+Function called(AST_Node root, CalcContext ctx, bool show_errors,
+                bool *complete, Value *result)
+{
+    bool fowned;
+    Value f = AST_evaluate_r(root->left, ctx, show_errors, complete,
+                             &fowned);
+    Function fn = NULL;
+    if (f.type == FUNCTION) fn = Function_share(f.u.fn);
+    else *result = product(root, f, ctx, show_errors, complete);
+    if (fowned) Value_free(&f);
+    return fn;
+}
+
+/* A name applied to one argument, but bound to something other than a */
+/* function, multiplies it, just as f * (x) would                      */
+Value product(AST_Node root, Value f, CalcContext ctx, bool show_errors,
+              bool *complete)
+{
+    AST_Node arg = root->right;
+    if ((arg == NULL) || (arg->v.type != OP) || (arg->v.u.op != ARG)) {
+        *complete = false;
+        return ILL_TYPED;
+    }
+    if (arg->right != NULL) {
+        if ((f.type != NONE) && (f.type != INVALID) && show_errors) {
+            Context_error(ctx, "Type mismatch: [%s] is of type [%s], not a "
+                               "function\n", callee(root),
+                               typestring(f.type));
+        }
+        return ILL_TYPED;
+    }
+
+    bool aowned;
+    Value a = AST_evaluate_r(arg->left, ctx, show_errors, complete, &aowned);
+    Value result = operate(root, PROD, f, a, ctx, show_errors);
+    if (aowned) Value_free(&a);
+    return result;
+}
+
+/* Evaluate root's arguments into args, one for each of fn's parameters */
+bool arguments(AST_Node root, Function fn, Value *args, CalcContext ctx,
+               bool show_errors, bool *complete)
+{
+    unsigned n = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++n) {
+        if ((arg->v.type != OP) || (arg->v.u.op != ARG)) {
+            *complete = false;
+            return false;
+        }
+    }
+    if (n != Function_arity(fn)) {
+        if (show_errors) {
+            Context_error(ctx, "Runtime error: Function [%s] expects %u "
+                               "argument%s, not %u\n", fn->name,
+                               Function_arity(fn),
+                               (Function_arity(fn) == 1) ? "" : "s", n);
+        }
+        return false;
+    }
+
+    unsigned i = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++i) {
+        bool aowned;
+        Value v = AST_evaluate_r(arg->left, ctx, show_errors, complete,
+                                 &aowned);
+        if ((v.type == NONE) || (v.type == INVALID)) {
+            if (aowned) Value_free(&v);
+            while (i > 0) Value_free(&args[--i]);
+            return false;
+        }
+        args[i] = aowned ? v : counted(Value_copy(v), ctx);
+    }
+    return true;
+}
+
+/* The node whose value is root's, reached through parentheses and the */
+/* branches conditionals take. NULL, once reported, if a condition     */
+/* fails                                                               */
+AST_Node tail_position(AST_Node root, CalcContext ctx, bool show_errors,
+                       bool *complete)
+{
+    while ((root != NULL) && (root->v.type == OP)) {
+        if ((root->v.u.op == PAREN) && (root->right != NULL)) {
+            root = root->right;
+        } else if (root->v.u.op == COND) {
+            if (!branch(root, ctx, show_errors, complete, &root)) {
+                return NULL;
+            }
+        } else break;
+    }
+    return root;
+}
+
+/* The library's functions take numbers, and are called directly */
+Value evaluate_builtin(AST_Node root, CalcContext ctx, bool show_errors,
+                       bool *complete, bool *owned)
+{
+    *owned = false;
+    const Builtin *b = root->left->v.u.builtin;
+
+    unsigned n = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++n) {
+        if ((arg->v.type != OP) || (arg->v.u.op != ARG)) {
+            *complete = false;
+            return ILL_TYPED;
+        }
+    }
+    if (n != b->arity) {
+        if (show_errors) {
+            Context_error(ctx, "Runtime error: Function [%s] expects %u "
+                               "argument%s, not %u\n", b->name, b->arity,
+                               (b->arity == 1) ? "" : "s", n);
+        }
+        return ILL_TYPED;
+    }
+
+    Value args[2];
+    unsigned i = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++i) {
+        bool aowned;
+        Value v = AST_evaluate_r(arg->left, ctx, show_errors, complete,
+                                 &aowned);
+        if (v.type != NUMBER) {
+            if ((v.type != NONE) && (v.type != INVALID) && show_errors) {
+                Context_error(ctx, "Type mismatch: Arguments of [%s] must "
+                                   "be of type [%s], not [%s]\n", b->name,
+                                   typestring(NUMBER), typestring(v.type));
+            }
+            if (aowned) Value_free(&v);
+            return ILL_TYPED;
+        }
+        // Numbers hold nothing to free
+        args[i] = v;
+    }
+
+    *owned = true;
+    return Builtin_call(b, args);
+}
+
+/* Each index is bound in a frame of its own, in which the term is        */
+/* evaluated. Terms that read nothing from outside the range but its      */
+/* environment may be evaluated on other threads; see Range_reduce        */
+Value evaluate_range(AST_Node root, CalcContext ctx, bool show_errors,
+                     bool *complete, bool *owned)
+{
+    *owned = false;
+
+    // The parser leaves an index, two bounds and a term
+    AST_Node args[4];
+    unsigned n = 0;
+    for (AST_Node arg = root->right; (arg != NULL) && (n < 4);
+            arg = arg->right) {
+        args[n++] = arg;
+    }
+    if ((n < 4) || (args[3]->right != NULL)) {
+        *complete = false;
+        return ILL_TYPED;
+    }
+
+    const char *name = callee(root);
+    int64_t lo;
+    int64_t hi;
+    if (!bound(args[1]->left, name, ctx, show_errors, complete, &lo) ||
+            !bound(args[2]->left, name, ctx, show_errors, complete, &hi)) {
+        return ILL_TYPED;
+    }
+
+    Term t = {args[3]->left, name};
+    Value v = Range_reduce(Range_reduction(name), lo, hi, range_term, &t,
+                           ctx, self_contained(t.body, 1), show_errors,
+                           complete);
+    if (v.type == NONE) return ILL_TYPED;
+    *owned = true;
+    return v;
+}
+
+/* arg is the Term to evaluate */
+bool range_term(void *arg, CalcContext ctx, int64_t i, bool show_errors,
+                bool *complete, Value *term)
+{
+    Term *t = arg;
+
+    Context_allocated(ctx, Stack_push(ctx->stack, 1));
+    *Stack_slot(ctx->stack, 0, 0) = Value_new_integer(i);
+    bool owned;
+    Value v = AST_evaluate_r(t->body, ctx, show_errors, complete, &owned);
+    bool number = (v.type == NUMBER);
+    if (number) {
+        // Numbers hold nothing to free, even when borrowed from the frame
+        *term = v;
     } else {
-        return Value_copy(root->v);
+        if ((v.type != NONE) && (v.type != INVALID) && show_errors) {
+            Context_error(ctx, "Type mismatch: Terms of [%s] must be of "
+                               "type [%s], not [%s]\n", t->name,
+                               typestring(NUMBER), typestring(v.type));
+        }
+        if (owned) Value_free(&v);
+    }
+    Stack_pop(ctx->stack);
+    return number;
+}
+
+/* A bound of the range called name, which must be a whole number */
+bool bound(AST_Node root, const char *name, CalcContext ctx,
+           bool show_errors, bool *complete, int64_t *i)
+{
+    bool owned;
+    Value v = AST_evaluate_r(root, ctx, show_errors, complete, &owned);
+    bool whole = (v.type == NUMBER) &&
+                 (v.integral || ((floor(v.u.d) == v.u.d) &&
+                                 (fabs(v.u.d) < 9.2e18)));
+    if (whole) *i = v.integral ? v.u.i : (int64_t) v.u.d;
+    else if ((v.type == NUMBER) && show_errors) {
+        Context_error(ctx, "Runtime error: Bounds of [%s] must be whole "
+                           "numbers, not [%.15g]\n", name, v.u.d);
+    } else if ((v.type != NONE) && (v.type != INVALID) && show_errors) {
+        Context_error(ctx, "Type mismatch: Bounds of [%s] must be of type "
+                           "[%s], not [%s]\n", name, typestring(NUMBER),
+                           typestring(v.type));
+    }
+    if (owned) Value_free(&v);
+    return whole;
+}
+
+/* Whether root, depth frames inside a range's, reads no local from      */
+/* outside the range and makes no calls, which could change what others */
+/* read                                                                  */
+bool self_contained(AST_Node root, unsigned depth)
+{
+    if (root == NULL) return true;
+
+    if (root->v.type == LOCAL) return root->v.u.local->depth < depth;
+    if (is_call(root)) return false;
+    if ((root->v.type == OP) && (root->v.u.op == RANGE)) {
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            unsigned inside = (arg->right == NULL) ? depth + 1 : depth;
+            if (!self_contained(arg->left, inside)) return false;
+        }
+        return true;
+    }
+    return self_contained(root->left, depth) &&
+           self_contained(root->right, depth);
+}
+
+/* Whether root calls a function of the script's */
+bool is_call(AST_Node root)
+{
+    return (root != NULL) && (root->v.type == OP) && (root->v.u.op == CALL) &&
+           (root->left->v.type != BUILTIN);
+}
+
+/* Whether root is written as a name applied to arguments */
+bool is_applied(AST_Node root)
+{
+    return (root->v.type == OP) &&
+           ((root->v.u.op == CALL) || (root->v.u.op == RANGE));
+}
+
+/* As %.15g prints it */
+void print_number(double x, FILE *out)
+{
+    char text[NUMBER_SIZE];
+    fwrite(text, 1, Number_format(x, false, text), out);
+}
+
+/* What root prints as: the number, string or boolean a variable is */
+/* bound to in e, as if substituted into the tree, or its own value  */
+Value shown(AST_Node root, Env e)
+{
+    if ((root->v.type != VAR) || (e == NULL)) return root->v;
+
+    Value v = Env_find(e, root->v.u.name);
+    if ((v.type == NUMBER) || (v.type == STRING) || (v.type == BOOL)) {
+        return v;
     }
+    return root->v;
+}
+
+/* The name a call, or reduction over a range, is made by */
+const char *callee(AST_Node root)
+{
+    Value v = root->left->v;
+    if (v.type == STRING) return v.u.s;
+    if (v.type == BUILTIN) return v.u.builtin->name;
+    return (v.type == LOCAL) ? v.u.local->name : v.u.name;
+}
+
+/* Whether lhs, as the left operand of root, is root's value: false for */
+/* && and true for ||, which then skip their right operand              */
+bool decides(AST_Node root, Value lhs)
+{
+    return (root->v.type == OP) && isLogical(root->v.u.op) &&
+           (lhs.type == BOOL) && (lhs.u.b == (root->v.u.op == DISJ));
+}
+
+bool AST_well_formed(AST_Node root)
+{
+    if (root == NULL) return false;
+
+    switch (root->v.type) {
+        case NONE:
+        case INVALID:
+            return false;
+        case RELAT_OP:
+            return AST_well_formed(root->left) &&
+                   AST_well_formed(root->right);
+        case OP:
+            break;
+        default:
+            return (root->left == NULL) && (root->right == NULL);
+    }
+
+    switch (root->v.u.op) {
+        case COND:
+            return AST_well_formed(root->left) && (root->right != NULL) &&
+                   AST_well_formed(root->right->left) &&
+                   AST_well_formed(root->right->right);
+        case CALL:
+            return AST_well_formed(root->left) && arguments_formed(root);
+        case RANGE:
+            // An index, two bounds and a term (see evaluate_range)
+            return AST_well_formed(root->left) && arguments_formed(root) &&
+                   (root->right != NULL) && (root->right->right != NULL) &&
+                   (root->right->right->right != NULL) &&
+                   (root->right->right->right->right != NULL) &&
+                   (root->right->right->right->right->right == NULL);
+        case ARG:
+            return false;
+        case PAREN:
+            return AST_well_formed(root->right);
+        default:
+            return AST_well_formed(root->left) &&
+                   AST_well_formed(root->right);
+    }
+}
+
+/* Whether each of the arguments root is applied to is well formed */
+bool arguments_formed(AST_Node root)
+{
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+        if ((arg->v.type != OP) || (arg->v.u.op != ARG) ||
+                !AST_well_formed(arg->left)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 AST_Node AST_rightmost(AST_Node root)
@@ -394,9 +1130,25 @@ bool bindsTighterThan(AST_Node lhs, AST_Node rhs)
     if (lhs->v.type == STRING) return true;
     if (rhs->v.type == STRING) return false;
 
+    // && and || bind more loosely than anything else, || the most
+    bool llogic = (lhs->v.type == OP) && isLogical(lhs->v.u.op);
+    bool rlogic = (rhs->v.type == OP) && isLogical(rhs->v.u.op);
+    if (llogic && rlogic) {
+        return hasHigherPriorityThan(lhs->v.u.op, rhs->v.u.op);
+    }
+    if (llogic || rlogic) return rlogic;
+
     if (lhs->v.type == RELAT_OP) return false;
     if (rhs->v.type == RELAT_OP) return true;
 
-    return hasHigherPriorityThan(lhs->v.u.op, rhs->v.u.op);
+    // Numbers and booleans bind as tightly as any other literal, and
+    // conditionals and calls as parenthesized groups do
+    return hasHigherPriorityThan(precedence(lhs), precedence(rhs));
 }
 
+OPERATOR precedence(AST_Node n)
+{
+    if (n->v.type != OP) return LITERAL;
+    return ((n->v.u.op == COND) || (n->v.u.op == CALL) ||
+            (n->v.u.op == RANGE)) ? PAREN : n->v.u.op;
+}
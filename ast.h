@@ -5,16 +5,41 @@
 #include "operator.h"
 
 #include "env.h"
+#include "context.h"
 #include "utility.h"
 
 #include "value.h"
 
 #include <stdbool.h>
+#include <stdio.h>
+
+/* How an operator node combines its operands once they are evaluated and */
+/* type checked. Anything but GENERAL is a cheaper route to the same kind  */
+/* of result, chosen by Reduce_tree                                        */
+typedef enum Kernel {
+    GENERAL = 0,
+    POWER,          /* Multiply chain for the small whole exponent k */
+    SQUARE_ROOT,
+    LOG2,
+    LOG10,
+    SCALED_LOG,     /* Natural log times k, the reciprocal of the base's */
+    LEFT,           /* The left operand is the result */
+    RIGHT           /* The right operand is the result */
+} Kernel;
 
 typedef struct AST_Node {
     struct AST_Node *left;
     struct AST_Node *right;
     Value v;
+    Kernel kernel;
+    double k;
+
+    /* Parents (and statements) holding this node, which Dag_intern may */
+    /* have shared between several of them                             */
+    unsigned refs;
+    /* For an operator shared that way, its memo slot in the context   */
+    /* (see AST_evaluate), numbered from 1; 0 otherwise                */
+    unsigned shared;
 } *AST_Node;
 
 AST_Node AST_new();
@@ -31,15 +56,29 @@ AST_Node AST_insertleaf(AST_Node n, AST_Node root);
 
 bool bindsTighterThan(AST_Node lhs, AST_Node rhs);
 
-void AST_print(AST_Node root);
-void AST_print_verbose(AST_Node root);
-
-void  AST_replace_vars(AST_Node root, Env e);
-// Will print runtime errors for any variables it sees.
-// Check integrity of AST structure
-bool  AST_validate(AST_Node root);
-Type  AST_typeof(AST_Node root, Env e, bool show_errors);
-Value AST_eval(AST_Node root);
+/* Variables bound in e to numbers, strings or booleans are printed as */
+/* their values; e may be NULL                                        */
+void AST_print(AST_Node root, Env e, FILE *out);
+void AST_print_verbose(AST_Node root, Env e, FILE *out);
+
+// Resolve, validate, typecheck and evaluate in a single traversal. The
+// result has type NONE or INVALID when a name is unbound or an operator is
+// given operands of the wrong type, which is reported if show_errors. &&
+// and || never look at their right operand once the left one decides the
+// result, nor a conditional at the branch it does not take, and so never
+// report on or fail because of those. If complete is not NULL it is set to
+// false when the tree is missing an operand or has one out of place.
+// Variables are read from ctx's environment, and locals from its stack, in
+// place; neither the tree nor the environment is modified, and the stack
+// only as far as binding a lazy slot on its first read. Shared operators
+// are evaluated once per call, unless they fail, in which case they are
+// evaluated (and report) again wherever they occur.
+Value AST_evaluate(AST_Node root, CalcContext ctx, bool show_errors,
+                   bool *complete);
+
+// Whether the tree has every operand in place, so that evaluating it could
+// only fail on its operands' types or values (see complete, above)
+bool AST_well_formed(AST_Node root);
 
 AST_Node AST_rightmost(AST_Node root);
 
@@ -1,5 +1,8 @@
 
 #include "binding.h"
+#include "function.h"
+#include "builtin.h"
+#include "number.h"
 #include "utility.h"
 
 #include <stdlib.h>
@@ -12,14 +15,17 @@
 
 Binding Binding_new(char *name, Value v)
 {
-    if (name == NULL) return EMPTY_BINDING;
+    if (name == NULL) {
+        Value_free(&v);
+        return EMPTY_BINDING;
+    }
 
     Binding nb = malloc(sizeof(*nb));
     if (nb == NULL) {
         perror("Binding_new");
         exit(EXIT_FAILURE);
     }
-    nb->value = Value_copy(v);
+    nb->value = v;
     nb->name = copy_string(name);
     nb->rest = EMPTY_BINDING;
 
@@ -43,6 +49,18 @@ Binding Binding_prepend(Binding new_b, Binding rest)
     return new_b;
 }
 
+bool Binding_rebind(Binding list, char *name, Value v)
+{
+    for (; list != EMPTY_BINDING; list = list->rest) {
+        if (strcmp(name, list->name) == 0) {
+            Value_free(&list->value);
+            list->value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
 Value Binding_find(Binding list, char *name)
 {
     if (list == EMPTY_BINDING) return NOTHING;
@@ -54,9 +72,11 @@ void Binding_print(Binding b)
 {
     if (b == NULL) return;
     
+    char number[NUMBER_SIZE];
     switch (b->value.type) {
         case NUMBER:
-            fprintf(stdout, "[%s] --> [%.15g]\n", b->name, b->value.u.d);
+            Number_format(Value_number(b->value), false, number);
+            fprintf(stdout, "[%s] --> [%s]\n", b->name, number);
             break;
         case STRING:
             fprintf(stdout, "[%s] --> [%s]\n", b->name, b->value.u.s);
@@ -68,10 +88,20 @@ void Binding_print(Binding b)
         case VAR:
             fprintf(stdout, "[%s] --> [%s]\n", b->name, b->value.u.name);
             break;
+        case FUNCTION:
+            fprintf(stdout, "[%s] --> [", b->name);
+            Function_print(b->value.u.fn, stdout);
+            fprintf(stdout, "]\n");
+            break;
+        case BUILTIN:
+            fprintf(stdout, "[%s] --> [<Builtin %s>]\n", b->name,
+                            b->value.u.builtin->name);
+            break;
         case NONE:
         case INVALID:
         case OP:
         case RELAT_OP:
+        case LOCAL:
             break;
     }
     Binding_print(b->rest);
@@ -4,6 +4,7 @@
 #include "value.h"
 
 #include <stdlib.h>
+#include <stdbool.h>
 
 #define T Binding
 typedef struct T *T;
@@ -16,12 +17,16 @@ struct T {
 
 static const T EMPTY_BINDING = NULL;
 
+/* Takes ownership of v; name is copied */
 T Binding_new(char *name, Value v);
 
 /* Free the entire chain of bindings */
 void Binding_free(T *b);
 
 T Binding_prepend(T new_b, T rest);
+/* Replace (and free) the value of an existing binding, taking ownership of
+ * v. Returns false, leaving v untouched, if name is not bound in list */
+bool Binding_rebind(T list, char *name, Value v);
 Value Binding_find(T list, char *name);
 
 void Binding_print(T b);
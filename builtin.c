@@ -0,0 +1,135 @@
+#include "builtin.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+/****************************************************************************/
+
+/* The loops are kept free of anything but the call, so that compilers */
+/* with vector versions of the library can use them                     */
+#define BATCH1(f)                                                           \
+    static void f##_n(const double *const *args, double *out, size_t n)    \
+    {                                                                       \
+        const double *x = args[0];                                          \
+        for (size_t i = 0; i < n; ++i) out[i] = f(x[i]);                    \
+    }
+#define BATCH2(f)                                                           \
+    static void f##_n(const double *const *args, double *out, size_t n)    \
+    {                                                                       \
+        const double *x = args[0];                                          \
+        const double *y = args[1];                                          \
+        for (size_t i = 0; i < n; ++i) out[i] = f(x[i], y[i]);              \
+    }
+
+BATCH1(sqrt)    BATCH1(cbrt)    BATCH1(exp)     BATCH1(exp2)
+BATCH1(expm1)   BATCH1(log)     BATCH1(log2)    BATCH1(log10)
+BATCH1(log1p)   BATCH1(sin)     BATCH1(cos)     BATCH1(tan)
+BATCH1(asin)    BATCH1(acos)    BATCH1(atan)    BATCH1(sinh)
+BATCH1(cosh)    BATCH1(tanh)    BATCH1(asinh)   BATCH1(acosh)
+BATCH1(atanh)   BATCH1(erf)     BATCH1(erfc)    BATCH1(tgamma)
+BATCH1(lgamma)  BATCH1(fabs)    BATCH1(floor)   BATCH1(ceil)
+BATCH1(round)   BATCH1(trunc)
+BATCH2(atan2)   BATCH2(hypot)   BATCH2(pow)
+
+static bool same(int64_t x, int64_t *result);
+static bool absolute(int64_t x, int64_t *result);
+static void build_index(void);
+static size_t hash_string(const char *s);
+
+#define UNARY(name, f)  {name, 1, f, NULL, f##_n, NULL}
+#define WHOLE(name, f, exact)  {name, 1, f, NULL, f##_n, exact}
+#define BINARY(name, f) {name, 2, NULL, f, f##_n, NULL}
+
+static const Builtin BUILTINS[] = {
+    UNARY("sqrt", sqrt),    UNARY("cbrt", cbrt),
+    UNARY("exp", exp),      UNARY("exp2", exp2),    UNARY("expm1", expm1),
+    UNARY("log", log),      UNARY("log2", log2),    UNARY("log10", log10),
+    UNARY("log1p", log1p),
+    UNARY("sin", sin),      UNARY("cos", cos),      UNARY("tan", tan),
+    UNARY("asin", asin),    UNARY("acos", acos),    UNARY("atan", atan),
+    UNARY("sinh", sinh),    UNARY("cosh", cosh),    UNARY("tanh", tanh),
+    UNARY("asinh", asinh),  UNARY("acosh", acosh),  UNARY("atanh", atanh),
+    UNARY("erf", erf),      UNARY("erfc", erfc),
+    UNARY("gamma", tgamma), UNARY("lgamma", lgamma),
+    WHOLE("abs", fabs, absolute),
+    WHOLE("floor", floor, same),    WHOLE("ceil", ceil, same),
+    WHOLE("round", round, same),    WHOLE("trunc", trunc, same),
+    BINARY("atan2", atan2), BINARY("hypot", hypot), BINARY("pow", pow)
+};
+static const unsigned NBUILTINS = sizeof(BUILTINS) / sizeof(*BUILTINS);
+
+/* Open addressed, from name to index + 1 (0 marks an empty entry). Built */
+/* once, by whichever thread looks a name up first                       */
+#define INDEX_SIZE 128
+static unsigned char table[INDEX_SIZE];
+static pthread_once_t indexed = PTHREAD_ONCE_INIT;
+
+/****************************************************************************/
+
+const Builtin *Builtin_find(const char *name)
+{
+    pthread_once(&indexed, build_index);
+
+    size_t mask = INDEX_SIZE - 1;
+    for (size_t i = hash_string(name) & mask; table[i] != 0;
+            i = (i + 1) & mask) {
+        const Builtin *b = &BUILTINS[table[i] - 1];
+        if (strcmp(b->name, name) == 0) return b;
+    }
+    return NULL;
+}
+
+double Builtin_apply(const Builtin *b, const double *args)
+{
+    return (b->arity == 1) ? b->unary(args[0]) : b->binary(args[0], args[1]);
+}
+
+Value Builtin_call(const Builtin *b, const Value *args)
+{
+    int64_t exact;
+    if ((b->exact != NULL) && args[0].integral &&
+            b->exact(args[0].u.i, &exact)) {
+        return Value_new_integer(exact);
+    }
+
+    double x[2];
+    for (unsigned i = 0; i < b->arity; ++i) x[i] = Value_number(args[i]);
+    return Value_new_number(Builtin_apply(b, x));
+}
+
+/****************************************************************************/
+
+bool same(int64_t x, int64_t *result)
+{
+    *result = x;
+    return true;
+}
+
+bool absolute(int64_t x, int64_t *result)
+{
+    if (x == INT64_MIN) return false;
+    *result = (x < 0) ? -x : x;
+    return true;
+}
+
+void build_index(void)
+{
+    size_t mask = INDEX_SIZE - 1;
+    for (unsigned j = 0; j < NBUILTINS; ++j) {
+        size_t i = hash_string(BUILTINS[j].name) & mask;
+        while (table[i] != 0) i = (i + 1) & mask;
+        table[i] = (unsigned char) (j + 1);
+    }
+}
+
+/* FNV-1a */
+size_t hash_string(const char *s)
+{
+    size_t h = 2166136261u;
+    for (; *s != '\0'; ++s) h = (h ^ (unsigned char) *s) * 16777619u;
+    return h;
+}
@@ -0,0 +1,46 @@
+#ifndef CALC_BUILTIN_H
+#define CALC_BUILTIN_H
+
+#include "value.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * The math library calls may be made to, such as sqrt(x) or         *
+ * atan2(y, x). Names are looked up in a hash table as a call is     *
+ * parsed, and the call then holds the entry, so that evaluating it  *
+ * goes straight to the C function. Each also has a batch form that  *
+ * applies it to whole arrays of arguments in one call, which is     *
+ * used for the rows of columns (see evaluate_rows in script.c).     *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef struct Builtin {
+    const char *name;
+    unsigned arity;
+
+    /* By arity */
+    double (*unary)(double);
+    double (*binary)(double, double);
+
+    /* out[i] is the function of args[0][i], ..., args[arity - 1][i] */
+    void (*batch)(const double *const *args, double *out, size_t n);
+
+    /* For functions taking whole numbers to whole numbers, the result */
+    /* for an integral argument, kept exact; false if it does not fit  */
+    bool (*exact)(int64_t x, int64_t *result);
+} Builtin;
+
+/* The function called name, if any */
+const Builtin *Builtin_find(const char *name);
+
+/* The function of arity args, as a double */
+double Builtin_apply(const Builtin *b, const double *args);
+
+/* As Builtin_apply, for Values, which must be NUMBERs */
+Value Builtin_call(const Builtin *b, const Value *args);
+
+#endif
@@ -0,0 +1,202 @@
+#include "columns.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/****************************************************************************/
+
+static const size_t HEADER_SIZE = 24;
+static const size_t DESCRIPTOR_SIZE = 48;
+
+typedef struct Column {
+    const char *name;
+    Column_type type;
+    const void *rows;
+} Column;
+
+struct Columns {
+    const unsigned char *map;
+    size_t size;
+
+    uint64_t nrows;
+    int ncolumns;
+    Column *columns;
+};
+
+static bool little_endian();
+static bool read_columns(Columns c, const char **why);
+
+/****************************************************************************/
+
+Columns Columns_open(const char *path, FILE *err)
+{
+    if (!little_endian()) {
+        if (err != NULL) {
+            fprintf(err, "%s: Columns can only be read on little-endian "
+                         "machines\n", path);
+        }
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if ((fd < 0) || (fstat(fd, &st) != 0)) {
+        if (err != NULL) fprintf(err, "%s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    if ((uint64_t) st.st_size < HEADER_SIZE) {
+        if (err != NULL) fprintf(err, "%s: Not a file of columns\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        if (err != NULL) fprintf(err, "%s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    // Rows are read once, in order
+    posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    Columns c = malloc(sizeof(*c));
+    if (c == NULL) {
+        perror("Columns_open");
+        exit(EXIT_FAILURE);
+    }
+    c->map = map;
+    c->size = st.st_size;
+    c->nrows = 0;
+    c->ncolumns = 0;
+    c->columns = NULL;
+
+    const char *why = NULL;
+    if (!read_columns(c, &why)) {
+        if (err != NULL) fprintf(err, "%s: %s\n", path, why);
+        Columns_free(&c);
+        return NULL;
+    }
+
+    return c;
+}
+
+void Columns_free(Columns *c)
+{
+    if ((c == NULL) || (*c == NULL)) return;
+
+    munmap((void *) (*c)->map, (*c)->size);
+    free((*c)->columns);
+    free(*c);
+    *c = NULL;
+}
+
+uint64_t Columns_rows(Columns c)
+{
+    return c->nrows;
+}
+
+int Columns_find(Columns c, const char *name)
+{
+    for (int i = 0; i < c->ncolumns; ++i) {
+        if (strcmp(c->columns[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+Column_type Columns_type(Columns c, int column)
+{
+    return c->columns[column].type;
+}
+
+const double *Columns_numbers(Columns c, int column)
+{
+    return c->columns[column].rows;
+}
+
+const uint8_t *Columns_bools(Columns c, int column)
+{
+    return c->columns[column].rows;
+}
+
+/****************************************************************************/
+
+bool little_endian()
+{
+    uint32_t one = 1;
+    return *(unsigned char *) &one == 1;
+}
+
+/* Check the header and descriptors, and find the columns they describe */
+bool read_columns(Columns c, const char **why)
+{
+    const unsigned char *map = c->map;
+    uint32_t version;
+    uint32_t ncolumns;
+    memcpy(&version, map + 8, sizeof(version));
+    memcpy(&ncolumns, map + 12, sizeof(ncolumns));
+    memcpy(&c->nrows, map + 16, sizeof(c->nrows));
+
+    if (memcmp(map, COLUMNS_MAGIC, 8) != 0) {
+        *why = "Not a file of columns";
+        return false;
+    }
+    if (version != COLUMNS_VERSION) {
+        *why = "Unsupported version of the columns format";
+        return false;
+    }
+    if (((c->size - HEADER_SIZE) / DESCRIPTOR_SIZE < ncolumns) ||
+            (ncolumns > INT_MAX)) {
+        *why = "Truncated column descriptors";
+        return false;
+    }
+
+    c->columns = malloc((ncolumns + 1) * sizeof(*c->columns));
+    if (c->columns == NULL) {
+        perror("Columns_open");
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t i = 0; i < ncolumns; ++i) {
+        const unsigned char *d = map + HEADER_SIZE + i * DESCRIPTOR_SIZE;
+        uint32_t type;
+        uint64_t offset;
+        memcpy(&type, d + COLUMNS_NAME_SIZE, sizeof(type));
+        memcpy(&offset, d + COLUMNS_NAME_SIZE + 8, sizeof(offset));
+
+        if ((memchr(d, '\0', COLUMNS_NAME_SIZE) == NULL) || (*d == '\0')) {
+            *why = "Column names must be 1 to 31 bytes long";
+            return false;
+        }
+
+        uint64_t width;
+        if (type == COLUMN_NUMBER) width = sizeof(double);
+        else if (type == COLUMN_BOOL) width = 1;
+        else {
+            *why = "Unknown column type";
+            return false;
+        }
+        if ((offset % width != 0) || (offset > c->size) ||
+                ((c->size - offset) / width < c->nrows)) {
+            *why = "Column out of place or truncated";
+            return false;
+        }
+
+        c->columns[i].name = (const char *) d;
+        c->columns[i].type = type;
+        c->columns[i].rows = map + offset;
+        c->ncolumns = i + 1;
+    }
+
+    return true;
+}
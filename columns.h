@@ -0,0 +1,51 @@
+#ifndef CALC_COLUMNS_H
+#define CALC_COLUMNS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define T Columns
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * A table of named columns read straight from a file mapped into    *
+ * memory, so that rows are neither parsed nor copied. The file is   *
+ * a header, a descriptor for each column and then the columns, one *
+ * after another, all little-endian:                                 *
+ *                                                                   *
+ *   header      MAGIC, then the uint32 version and number of        *
+ *               columns and the uint64 number of rows               *
+ *   descriptor  the name, NUL-padded to 32 bytes; the uint32 type   *
+ *               and 4 zero bytes; the uint64 offset of the column   *
+ *               from the start of the file                          *
+ *   number      a double per row, at an offset that is a multiple   *
+ *               of 8                                                *
+ *   boolean     a byte per row, 0 or 1                              *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#define COLUMNS_MAGIC "CALCCOL\0"
+#define COLUMNS_VERSION 1
+/* Names are NUL-terminated within the 32 bytes */
+#define COLUMNS_NAME_SIZE 32
+
+typedef enum Column_type {COLUMN_NUMBER = 1, COLUMN_BOOL} Column_type;
+
+/* NULL, once why has been reported to err, if path cannot be mapped or */
+/* is not a well-formed file of columns                                 */
+T    Columns_open(const char *path, FILE *err);
+void Columns_free(T *c);
+
+uint64_t Columns_rows(T c);
+
+/* The first column called name, or -1 if there is none */
+int         Columns_find(T c, const char *name);
+Column_type Columns_type(T c, int column);
+/* The rows of a COLUMN_NUMBER column */
+const double  *Columns_numbers(T c, int column);
+/* The rows of a COLUMN_BOOL column */
+const uint8_t *Columns_bools(T c, int column);
+
+#undef T
+#endif
@@ -0,0 +1,91 @@
+
+#include "context.h"
+#include "profile.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <stdarg.h>
+
+/****************************************************************************/
+
+CalcContext Context_new(Env e, FILE *out, FILE *err)
+{
+    CalcContext ctx = malloc(sizeof(*ctx));
+    if (ctx == NULL) {
+        perror("Context_new");
+        exit(EXIT_FAILURE);
+    }
+    ctx->filename = "Standard Input";
+    ctx->line_number = 0;
+    ctx->verbosity = NORMAL;
+    ctx->echo = YES;
+    ctx->digits = ROUNDED;
+    ctx->output = TEXT;
+    ctx->prompt = "";
+    ctx->out = out;
+    ctx->err = err;
+    ctx->env = e;
+    ctx->stack = Stack_new();
+    ctx->unwinding = false;
+    ctx->functions = Env_new();
+    ctx->undecided = false;
+    ctx->memos = NULL;
+    ctx->nmemos = 0;
+    ctx->generation = 0;
+    ctx->threads = 0;
+    ctx->profile = NULL;
+
+    return ctx;
+}
+
+void Context_free(CalcContext *ctx)
+{
+    if (ctx == NULL || *ctx == NULL) return;
+
+    for (unsigned i = 0; i < (*ctx)->nmemos; ++i) {
+        Value_free(&(*ctx)->memos[i].v);
+    }
+    free((*ctx)->memos);
+    Stack_free(&(*ctx)->stack);
+    Env_free(&(*ctx)->functions);
+    Env_free(&(*ctx)->env);
+    free(*ctx);
+    *ctx = NULL;
+}
+
+Memo *Context_memo(CalcContext ctx, unsigned i)
+{
+    if (i > ctx->nmemos) {
+        unsigned n = (2 * ctx->nmemos > i) ? 2 * ctx->nmemos : i;
+        ctx->memos = realloc(ctx->memos, n * sizeof(*ctx->memos));
+        if (ctx->memos == NULL) {
+            perror("Context_memo");
+            exit(EXIT_FAILURE);
+        }
+        Context_allocated(ctx, 1);
+        for (unsigned j = ctx->nmemos; j < n; ++j) {
+            ctx->memos[j].generation = 0;
+            ctx->memos[j].complete = true;
+            ctx->memos[j].v = NOTHING;
+        }
+        ctx->nmemos = n;
+    }
+    return &ctx->memos[i - 1];
+}
+
+void Context_allocated(CalcContext ctx, unsigned n)
+{
+    if ((ctx->profile != NULL) && (n > 0)) Profile_allocations(ctx->profile, n);
+}
+
+void Context_error(CalcContext ctx, const char *format, ...)
+{
+    if ((ctx == NULL) || (ctx->err == NULL) || ctx->unwinding) return;
+
+    va_list args;
+    va_start(args, format);
+    fprintf(ctx->err, "%s [Line %d]: ", ctx->filename, ctx->line_number);
+    vfprintf(ctx->err, format, args);
+    va_end(args);
+}
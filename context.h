@@ -0,0 +1,98 @@
+#ifndef CALC_CONTEXT_H
+#define CALC_CONTEXT_H 
+
+#include "env.h"
+#include "stack.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Everything one interpreter reads or writes while it runs: its     *
+ * environment and frames, its position in the input, its output     *
+ * settings and where diagnostics go. Interpreters with separate     *
+ * contexts share no mutable state and may run on separate threads.  *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef enum VERBOSITY {QUIET, NORMAL, VERBOSE} VERBOSITY;
+typedef enum ECHO {YES, NO} ECHO;
+/* Numbers are printed as %.15g prints them, or with as many more digits */
+/* as it takes for them to read back as the same number                  */
+typedef enum DIGITS {ROUNDED, SHORTEST} DIGITS;
+/* Results are printed as text, or written as the records of record.h */
+/* with no prompts or echo                                           */
+typedef enum OUTPUT {TEXT, BINARY} OUTPUT;
+
+/* The value of a shared subexpression, if it was computed during the */
+/* evaluation numbered generation                                     */
+typedef struct Memo {
+    unsigned long long generation;
+    bool complete;
+    Value v;
+} Memo;
+
+struct Profile;
+
+#define T CalcContext
+typedef struct T *T;
+
+struct T {
+    const char *filename;
+    unsigned int line_number;
+
+    VERBOSITY verbosity;
+    ECHO echo;
+    DIGITS digits;
+    OUTPUT output;
+    const char *prompt;
+
+    FILE *out;
+    /* NULL discards diagnostics */
+    FILE *err;
+
+    Env env;
+    Stack stack;
+    /* Set when calls nest too deeply, until the evaluation under way is */
+    /* over; the callers' diagnostics as they fail in turn are dropped   */
+    bool unwinding;
+
+    /* Names the parser has seen defined as functions (true) and bound */
+    /* otherwise since (false), so that it can tell whether sqrt(x),   */
+    /* say, calls a function of the script's or the library's          */
+    Env functions;
+    /* Set by a parser without an environment on meeting such a name   */
+    /* that a let bound to what it cannot tell is a function or not    */
+    bool undecided;
+
+    Memo *memos;
+    unsigned nmemos;
+    unsigned long long generation;
+
+    /* The most threads a long range is reduced on, 0 for one for each */
+    /* processor                                                       */
+    unsigned threads;
+
+    /* What evaluation is credited to, if it is being profiled; not */
+    /* freed with the context                                       */
+    struct Profile *profile;
+};
+
+/* Takes ownership of the innermost frame of e; any environments it */
+/* extends are left to the caller                                   */
+T    Context_new(Env e, FILE *out, FILE *err);
+void Context_free(T *ctx);
+
+/* The memo for shared subexpression number i, from 1 */
+Memo *Context_memo(T ctx, unsigned i);
+
+/* Count n allocations towards ctx's profile, if it has one */
+void Context_allocated(T ctx, unsigned n);
+
+/* Report a diagnostic, prefixed with the current file and line, unless */
+/* unwinding                                                           */
+void Context_error(T ctx, const char *format, ...);
+
+#undef T
+#endif
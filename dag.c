@@ -0,0 +1,211 @@
+
+#include "dag.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/****************************************************************************/
+
+struct Dag {
+    /* Open addressing, linear probing */
+    AST_Node *slots;
+    size_t capacity;
+    size_t size;
+
+    unsigned merged;
+    unsigned numbered;
+};
+
+static size_t hash(AST_Node n);
+static size_t hash_string(const char *s);
+static bool   same(AST_Node a, AST_Node b);
+static void   grow(Dag d);
+
+/****************************************************************************/
+
+Dag Dag_new()
+{
+    Dag d = malloc(sizeof(*d));
+    if (d == NULL) {
+        perror("Dag_new");
+        exit(EXIT_FAILURE);
+    }
+    d->slots = NULL;
+    d->capacity = 0;
+    d->size = 0;
+    d->merged = 0;
+    d->numbered = 0;
+
+    return d;
+}
+
+void Dag_free(Dag *d)
+{
+    if (d == NULL || *d == NULL) return;
+
+    // The nodes belong to the trees
+    free((*d)->slots);
+    free(*d);
+    *d = NULL;
+}
+
+AST_Node Dag_intern(Dag d, AST_Node root)
+{
+    if (root == NULL) return NULL;
+
+    // A range's term is evaluated once for each index, which a memo would
+    // miss, and its locals address other frames than the same ones outside
+    // do, so only its bounds are shared, and the range itself is not
+    if ((root->v.type == OP) && (root->v.u.op == RANGE)) {
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            if ((arg != root->right) && (arg->right != NULL)) {
+                arg->left = Dag_intern(d, arg->left);
+            }
+        }
+        return root;
+    }
+
+    root->left = Dag_intern(d, root->left);
+    root->right = Dag_intern(d, root->right);
+
+    // Malformed nodes are left unshared, so each reports its own errors
+    if ((root->v.type == NONE) || (root->v.type == INVALID)) return root;
+
+    if (4 * (d->size + 1) > 3 * d->capacity) grow(d);
+
+    size_t mask = d->capacity - 1;
+    size_t i = hash(root) & mask;
+    for (; d->slots[i] != NULL; i = (i + 1) & mask) {
+        if (same(d->slots[i], root)) {
+            AST_Node shared = d->slots[i];
+            ++shared->refs;
+            AST_free(&root);
+            if ((shared->v.type == OP) || (shared->v.type == RELAT_OP)) {
+                ++d->merged;
+            }
+            return shared;
+        }
+    }
+    d->slots[i] = root;
+    ++d->size;
+
+    return root;
+}
+
+unsigned Dag_number(Dag d, AST_Node root)
+{
+    if (root == NULL) return d->numbered;
+
+    if ((root->refs > 1) && (root->shared == 0) &&
+            ((root->v.type == OP) || (root->v.type == RELAT_OP))) {
+        root->shared = ++d->numbered;
+    }
+    Dag_number(d, root->left);
+    Dag_number(d, root->right);
+
+    return d->numbered;
+}
+
+unsigned Dag_merged(Dag d)
+{
+    return d->merged;
+}
+
+unsigned Dag_size(Dag d)
+{
+    return d->size;
+}
+
+/****************************************************************************/
+
+/* Children are already interned, so they compare by identity */
+size_t hash(AST_Node n)
+{
+    size_t h = (size_t) n->v.type * 0x9E3779B97F4A7C15u;
+    uint64_t bits = 0;
+
+    switch (n->v.type) {
+        case NUMBER:
+            memcpy(&bits, &n->v.u, sizeof(bits));
+            h ^= (size_t) (bits ^ (bits >> 29)) + n->v.integral;
+            break;
+        case STRING:    h ^= hash_string(n->v.u.s); break;
+        case VAR:       h ^= hash_string(n->v.u.name); break;
+        case BOOL:      h ^= n->v.u.b; break;
+        case OP:        h ^= n->v.u.op; break;
+        case RELAT_OP:  h ^= n->v.u.rop; break;
+        case LOCAL:
+            h ^= (n->v.u.local->depth * 31u) + n->v.u.local->slot;
+            break;
+        case FUNCTION:  h ^= (size_t) (uintptr_t) n->v.u.fn; break;
+        case BUILTIN:   h ^= (size_t) (uintptr_t) n->v.u.builtin; break;
+        case NONE:
+        case INVALID:
+            break;
+    }
+    h = (h * 31) + (size_t) (uintptr_t) n->left;
+    h = (h * 31) + (size_t) (uintptr_t) n->right;
+    return h ^ (h >> 17);
+}
+
+/* FNV-1a */
+size_t hash_string(const char *s)
+{
+    size_t h = 2166136261u;
+    for (; *s != '\0'; ++s) h = (h ^ (unsigned char) *s) * 16777619u;
+    return h;
+}
+
+bool same(AST_Node a, AST_Node b)
+{
+    if ((a->v.type != b->v.type) || (a->left != b->left) ||
+            (a->right != b->right)) {
+        return false;
+    }
+
+    switch (a->v.type) {
+        case NUMBER:
+            // Bit for bit, so that 0 and -0 stay apart
+            return (a->v.integral == b->v.integral) &&
+                   (memcmp(&a->v.u, &b->v.u, sizeof(a->v.u.d)) == 0);
+        case STRING:    return strcmp(a->v.u.s, b->v.u.s) == 0;
+        case VAR:       return strcmp(a->v.u.name, b->v.u.name) == 0;
+        case BOOL:      return a->v.u.b == b->v.u.b;
+        case OP:        return a->v.u.op == b->v.u.op;
+        case RELAT_OP:  return a->v.u.rop == b->v.u.rop;
+        case LOCAL:
+            return (a->v.u.local->depth == b->v.u.local->depth) &&
+                   (a->v.u.local->slot == b->v.u.local->slot) &&
+                   (strcmp(a->v.u.local->name, b->v.u.local->name) == 0);
+        case FUNCTION:  return a->v.u.fn == b->v.u.fn;
+        case BUILTIN:   return a->v.u.builtin == b->v.u.builtin;
+        case NONE:
+        case INVALID:
+            return false;
+    }
+    return false;
+}
+
+void grow(Dag d)
+{
+    size_t capacity = (d->capacity == 0) ? 64 : 2 * d->capacity;
+    AST_Node *slots = calloc(capacity, sizeof(*slots));
+    if (slots == NULL) {
+        perror("Dag_intern");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t j = 0; j < d->capacity; ++j) {
+        if (d->slots[j] == NULL) continue;
+        size_t i = hash(d->slots[j]) & (capacity - 1);
+        while (slots[i] != NULL) i = (i + 1) & (capacity - 1);
+        slots[i] = d->slots[j];
+    }
+    free(d->slots);
+    d->slots = slots;
+    d->capacity = capacity;
+}
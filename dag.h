@@ -0,0 +1,37 @@
+#ifndef CALC_DAG_H
+#define CALC_DAG_H 
+
+#include "ast.h"
+
+#define T Dag
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Hash-consing of a statement's trees. Structurally identical       *
+ * subtrees are merged into one node with a reference per parent,    *
+ * and operators that end up shared are numbered so that evaluation  *
+ * can compute each of them once (see AST_evaluate).                 *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+T    Dag_new();
+void Dag_free(T *d);
+
+/* Takes root and returns its replacement, which may share nodes with */
+/* every tree interned into d before it                               */
+AST_Node Dag_intern(T d, AST_Node root);
+
+/* Number the shared operators in root, continuing from those numbered */
+/* already. Returns how many have been numbered in total               */
+unsigned Dag_number(T d, AST_Node root);
+
+/* How many repeated operators, with all below them, interning has */
+/* merged away. Repeated leaves are shared too, but not counted     */
+unsigned Dag_merged(T d);
+/* How many distinct nodes are left in the trees interned into d, not */
+/* counting the terms of ranges                                       */
+unsigned Dag_size(T d);
+
+#undef T
+#endif
@@ -0,0 +1,761 @@
+
+#include "emit.h"
+#include "script.h"
+#include "parse.h"
+#include "statement.h"
+#include "utility.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+/****************************************************************************/
+
+typedef struct Emitter {
+    CalcContext ctx;
+
+    /* File-scope variables holding let-bound values */
+    FILE *decls;
+    char *decls_text;
+    size_t decls_size;
+
+    /* The statements of main */
+    FILE *body;
+    char *body_text;
+    size_t body_size;
+
+    /* The C variable each let-bound name currently lives in. Other names */
+    /* are the basis's constants                                         */
+    char **names;
+    unsigned *vars;
+    unsigned nnames;
+    unsigned nvars;
+
+    /* Types of the where bindings of the current line, once bound */
+    Type *slots;
+
+    bool uses_cat;
+    bool uses_print_string;
+    bool uses_print_number;
+    bool uses_log;
+    bool uses_int;
+    bool uses_power;
+    bool uses_chain;
+    bool uses_sqrt;
+} Emitter;
+
+static void emit_line(Emitter *em, char *line);
+static void emit_where(Emitter *em, Scope where);
+static void emit_print(Emitter *em, Type t, bool exact, const char *var);
+static void emit_expr(Emitter *em, AST_Node root);
+static void emit_conditional(Emitter *em, AST_Node root);
+static void emit_call(Emitter *em, AST_Node root);
+static void emit_operand(Emitter *em, AST_Node root);
+static void emit_integer_op(Emitter *em, AST_Node root);
+static bool emit_kernel(Emitter *em, AST_Node root);
+static void emit_value(Emitter *em, Value v);
+static void emit_literal(FILE *out, const char *text, size_t len);
+static void emit_runtime(Emitter *em, FILE *out);
+
+static Type type_of(Emitter *em, AST_Node root);
+static bool integral(Emitter *em, AST_Node root);
+static bool decided(Emitter *em, AST_Node root);
+static AST_Node taken(Emitter *em, AST_Node root);
+static int  lookup(Emitter *em, const char *name);
+static const char *ctype(Type t, bool exact);
+static const char *crelop(RELOP rop);
+static FILE *open_buffer(char **text, size_t *size);
+
+/****************************************************************************/
+
+void Emit_c(CalcContext ctx, FILE *in, FILE *out)
+{
+    Emitter em;
+    memset(&em, 0, sizeof(em));
+    em.ctx = ctx;
+    em.decls = open_buffer(&em.decls_text, &em.decls_size);
+    em.body = open_buffer(&em.body_text, &em.body_size);
+
+    FILE *ctx_out = ctx->out;
+    FILE *ctx_err = ctx->err;
+
+    char *line = NULL;
+    size_t size = 0;
+    size_t len = 0;
+
+    while ((len = my_getline(&line, &size, in)) != (size_t) -1) {
+        ++ctx->line_number;
+        line[--len] = '\0';
+        if (len != 0) emit_line(&em, line);
+    }
+    free(line);
+
+    ctx->out = ctx_out;
+    ctx->err = ctx_err;
+    fclose(em.decls);
+    fclose(em.body);
+
+    fprintf(out, "/* Generated by calc --emit-c from %s */\n\n",
+                 ctx->filename);
+    fprintf(out, "#include <math.h>\n#include <stdint.h>\n"
+                 "#include <stdio.h>\n#include <stdlib.h>\n"
+                 "#include <string.h>\n\n");
+    emit_runtime(&em, out);
+    fputs(em.decls_text, out);
+    fprintf(out, "\nint main(void)\n{\n");
+    fputs(em.body_text, out);
+    fprintf(out, "    putchar('\\n');\n    return 0;\n}\n");
+
+    for (unsigned i = 0; i < em.nnames; ++i) free(em.names[i]);
+    free(em.names);
+    free(em.vars);
+    free(em.decls_text);
+    free(em.body_text);
+}
+
+/****************************************************************************/
+
+void emit_line(Emitter *em, char *line)
+{
+    CalcContext ctx = em->ctx;
+
+    // Whatever the interpreter reports, the program reports verbatim
+    char *out_text = NULL;
+    size_t out_size = 0;
+    char *err_text = NULL;
+    size_t err_size = 0;
+    ctx->out = open_buffer(&out_text, &out_size);
+    ctx->err = open_buffer(&err_text, &err_size);
+
+    Statement st = parse(line, ctx);
+
+    if (ftell(em->body) > 0) fputc('\n', em->body);
+    fprintf(em->body, "    /* %u: ", ctx->line_number);
+    for (char *walk = line; *walk != '\0'; ++walk) {
+        if ((*walk == '*') && (walk[1] == '/')) fputs("* ", em->body);
+        else fputc(*walk, em->body);
+    }
+    fprintf(em->body, " */\n    {\n");
+
+    // Types are worked out before the line's own binding takes effect
+    Type t = NONE;
+    unsigned nslots = (st->where != NULL) ? st->where->size : 0;
+    em->slots = malloc((nslots + 1) * sizeof(*em->slots));
+    if (em->slots == NULL) {
+        perror("Emit_c");
+        exit(EXIT_FAILURE);
+    }
+    // The where clause is bound as the interpreter would, so that which
+    // subexpressions it keeps integral can be asked of it
+    Scope_push(st->where, ctx);
+    if (st->root != NULL) {
+        emit_where(em, st->where);
+        t = type_of(em, st->root);
+    }
+
+    char var[32];
+    bool valid = (t == NUMBER) || (t == STRING) || (t == BOOL);
+    bool exact = valid && integral(em, st->root);
+    if (valid) {
+        if (st->name != NULL) {
+            sprintf(var, "v%u", em->nvars++);
+            fprintf(em->decls, "static %s%s;\n", ctype(t, exact), var);
+        } else {
+            sprintf(var, "result");
+            fprintf(em->body, "        %sresult;\n", ctype(t, exact));
+        }
+        fprintf(em->body, "        %s = ", var);
+        emit_expr(em, st->root);
+        fprintf(em->body, ";\n");
+    }
+    if (st->where != NULL) Stack_pop(ctx->stack);
+    free(em->slots);
+    em->slots = NULL;
+
+    Script_statement(ctx, st);
+    fclose(ctx->err);
+    fclose(ctx->out);
+
+    if (err_size > 0) {
+        fprintf(em->body, "        fputs(");
+        emit_literal(em->body, err_text, err_size);
+        fprintf(em->body, ", stderr);\n");
+    }
+    // Such as the function a definition binds
+    if (!valid && (out_size > 0)) {
+        fprintf(em->body, "        fputs(");
+        emit_literal(em->body, out_text, out_size);
+        fprintf(em->body, ", stdout);\n");
+    }
+
+    if (valid) {
+        // Echo depends only on the tree and the variables it was evaluated
+        // with, so it can be printed as is
+        bool echoed = (st->name == NULL) && (ctx->echo == YES) &&
+                      (ctx->verbosity != QUIET) &&
+                      ((st->root->v.type == OP) ||
+                       (st->root->v.type == RELAT_OP));
+        if (echoed) {
+            char *echo_text = NULL;
+            size_t echo_size = 0;
+            FILE *echo = open_buffer(&echo_text, &echo_size);
+            if (ctx->verbosity == VERBOSE) {
+                AST_print_verbose(st->root, ctx->env, echo);
+            } else AST_print(st->root, ctx->env, echo);
+            fclose(echo);
+            fprintf(em->body, "        fputs(");
+            emit_literal(em->body, echo_text, echo_size);
+            fprintf(em->body, ", stdout);\n");
+            free(echo_text);
+        }
+        emit_print(em, t, exact, var);
+    }
+    fprintf(em->body, "    }\n");
+
+    if (valid && (st->name != NULL)) {
+        int i = lookup(em, st->name);
+        if (i < 0) {
+            em->names = realloc(em->names,
+                                (em->nnames + 1) * sizeof(*em->names));
+            em->vars = realloc(em->vars, (em->nnames + 1) * sizeof(*em->vars));
+            if ((em->names == NULL) || (em->vars == NULL)) {
+                perror("Emit_c");
+                exit(EXIT_FAILURE);
+            }
+            i = em->nnames++;
+            em->names[i] = copy_string(st->name);
+        }
+        em->vars[i] = em->nvars - 1;
+    }
+
+    Statement_free(&st);
+    free(out_text);
+    free(err_text);
+}
+
+/* Declare the where bindings that would bind, each after those it refers */
+/* to. The interpreter binds only those it reads, but binding the rest as */
+/* well does no harm in C                                                 */
+void emit_where(Emitter *em, Scope where)
+{
+    if (where == NULL) return;
+
+    for (unsigned i = 0; i < where->size; ++i) em->slots[i] = NONE;
+
+    for (unsigned k = 0; k < where->size; ++k) {
+        unsigned i = where->order[k];
+        Type t = type_of(em, where->exprs[i]);
+        if ((t == NONE) || (t == INVALID)) continue;
+
+        fprintf(em->body, "        %sw%u = ",
+                          ctype(t, integral(em, where->exprs[i])), i);
+        emit_expr(em, where->exprs[i]);
+        fprintf(em->body, ";\n        (void) w%u;\n", i);
+        em->slots[i] = t;
+    }
+}
+
+void emit_print(Emitter *em, Type t, bool exact, const char *var)
+{
+    switch (t) {
+        case NUMBER:
+            if (em->ctx->digits == SHORTEST) {
+                em->uses_print_number = true;
+                fprintf(em->body, "        calc_print_number(%s%s);\n",
+                                  exact ? "(double) " : "", var);
+                break;
+            }
+            fprintf(em->body, "        printf(\"= %%.15g\\n\", %s%s);\n",
+                              exact ? "(double) " : "", var);
+            break;
+        case STRING:
+            em->uses_print_string = true;
+            fprintf(em->body, "        putchar('\"');\n"
+                              "        calc_print_string(%s);\n"
+                              "        fputs(\"\\\"\\n\", stdout);\n", var);
+            break;
+        case BOOL:
+            fprintf(em->body, "        puts(%s ? \"= <True>\" : "
+                              "\"= <False>\");\n", var);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Only called on trees the interpreter evaluates without error */
+void emit_expr(Emitter *em, AST_Node root)
+{
+    FILE *out = em->body;
+    int i;
+    Type lhs;
+    bool exact;
+
+    switch (root->v.type) {
+        case NUMBER:
+        case STRING:
+        case BOOL:
+            emit_value(em, root->v);
+            break;
+        case VAR:
+            i = lookup(em, root->v.u.name);
+            if (i >= 0) fprintf(out, "v%u", em->vars[i]);
+            else emit_value(em, Env_find(em->ctx->env, root->v.u.name));
+            break;
+        case LOCAL:
+            fprintf(out, "w%u", root->v.u.local->slot);
+            break;
+        case RELAT_OP:
+            lhs = type_of(em, root->left);
+            fprintf(out, (lhs == STRING) ? "(strcmp(" : "(");
+            exact = integral(em, root->left) && integral(em, root->right);
+            if (exact) emit_expr(em, root->left);
+            else emit_operand(em, root->left);
+            fprintf(out, (lhs == STRING) ? ", " : " %s ",
+                         crelop(root->v.u.rop));
+            if (exact) emit_expr(em, root->right);
+            else emit_operand(em, root->right);
+            if (lhs == STRING) fprintf(out, ") %s 0)", crelop(root->v.u.rop));
+            else fprintf(out, ")");
+            break;
+        case FUNCTION:
+        case BUILTIN:
+            break;
+        case OP:
+            if (root->v.u.op == PAREN) {
+                emit_expr(em, root->right);
+                break;
+            }
+            if (root->v.u.op == COND) {
+                emit_conditional(em, root);
+                break;
+            }
+            if ((root->v.u.op == CALL) || (root->v.u.op == RANGE)) {
+                emit_call(em, root);
+                break;
+            }
+            if (isLogical(root->v.u.op)) {
+                // A right operand that is not a boolean is always skipped
+                fprintf(out, "(");
+                emit_expr(em, root->left);
+                if (type_of(em, root->right) == BOOL) {
+                    fprintf(out, " %s ", OPERATORtosymbol(root->v.u.op));
+                    emit_expr(em, root->right);
+                }
+                fprintf(out, ")");
+                break;
+            }
+            if (integral(em, root)) {
+                emit_integer_op(em, root);
+                break;
+            }
+            if (emit_kernel(em, root)) break;
+            if (type_of(em, root->left) == STRING) {
+                em->uses_cat = true;
+                fprintf(out, "calc_cat(");
+            } else switch (root->v.u.op) {
+                case EXP:   fprintf(out, "pow("); break;
+                case LOG:   em->uses_log = true;
+                            fprintf(out, "calc_log(");
+                            break;
+                case MOD:   fprintf(out, "fmod("); break;
+                case INT:   em->uses_int = true;
+                            fprintf(out, "calc_int(");
+                            break;
+                default:    fprintf(out, "("); break;
+            }
+            emit_operand(em, root->left);
+            switch (root->v.u.op) {
+                case PROD:  fprintf(out, " * "); break;
+                case QUOT:  fprintf(out, " / "); break;
+                case DIFF:  fprintf(out, " - "); break;
+                case SUM:   fprintf(out, (type_of(em, root->left) == STRING) ?
+                                         ", " : " + ");
+                            break;
+                default:    fprintf(out, ", "); break;
+            }
+            emit_operand(em, root->right);
+            fprintf(out, ")");
+            break;
+        case NONE:
+        case INVALID:
+            break;
+    }
+}
+
+/* As a C conditional if the branches agree in type, and as the branch */
+/* the interpreter takes otherwise                                     */
+void emit_conditional(Emitter *em, AST_Node root)
+{
+    FILE *out = em->body;
+    AST_Node branch = taken(em, root);
+    AST_Node other = (branch == root->right->left) ? root->right->right :
+                                                     root->right->left;
+    if ((type_of(em, other) != type_of(em, branch)) ||
+            (integral(em, other) != integral(em, branch))) {
+        emit_expr(em, branch);
+        return;
+    }
+
+    fprintf(out, "(");
+    emit_expr(em, root->left);
+    fprintf(out, " ? ");
+    emit_expr(em, root->right->left);
+    fprintf(out, " : ");
+    emit_expr(em, root->right->right);
+    fprintf(out, ")");
+}
+
+/* As the value the call, or reduction over a range, comes to. Everything */
+/* either can read is known by now, so it is evaluated here, once, rather */
+/* than in the program                                                    */
+void emit_call(Emitter *em, AST_Node root)
+{
+    Value v = AST_evaluate(root, em->ctx, false, NULL);
+    emit_value(em, v);
+    Value_free(&v);
+}
+
+/* Integral values meet doubles as doubles, as in Value_combine */
+void emit_operand(Emitter *em, AST_Node root)
+{
+    if (integral(em, root)) fprintf(em->body, "(double) ");
+    emit_expr(em, root);
+}
+
+/* The interpreter found this exact, so its operands are integral and */
+/* the integer arithmetic cannot overflow                             */
+void emit_integer_op(Emitter *em, AST_Node root)
+{
+    FILE *out = em->body;
+
+    if (root->v.u.op == EXP) {
+        em->uses_power = true;
+        fprintf(out, "calc_power(");
+    } else fprintf(out, "(");
+    emit_expr(em, root->left);
+    switch (root->v.u.op) {
+        case PROD:  fprintf(out, " * "); break;
+        case QUOT:
+        case INT:   fprintf(out, " / "); break;
+        case MOD:   fprintf(out, " %% "); break;
+        case SUM:   fprintf(out, " + "); break;
+        case DIFF:  fprintf(out, " - "); break;
+        default:    fprintf(out, ", "); break;
+    }
+    emit_expr(em, root->right);
+    fprintf(out, ")");
+}
+
+/* Reduce_combine's shortcuts, where it would take them */
+bool emit_kernel(Emitter *em, AST_Node root)
+{
+    FILE *out = em->body;
+
+    if ((root->kernel == GENERAL) || (type_of(em, root->left) != NUMBER)) {
+        return false;
+    }
+    if (integral(em, root->left) && integral(em, root->right) &&
+            (root->v.u.op != LOG)) {
+        return false;
+    }
+
+    switch (root->kernel) {
+        case POWER:
+            em->uses_chain = true;
+            fprintf(out, "calc_chain(");
+            emit_operand(em, root->left);
+            fprintf(out, ", %u)", (unsigned) root->k);
+            break;
+        case SQUARE_ROOT:
+            em->uses_sqrt = true;
+            fprintf(out, "calc_sqrt(");
+            emit_operand(em, root->left);
+            fprintf(out, ")");
+            break;
+        case LOG2:
+        case LOG10:
+        case SCALED_LOG:
+            fprintf(out, (root->kernel == LOG2) ? "log2(" :
+                         (root->kernel == LOG10) ? "log10(" : "(log(");
+            emit_operand(em, root->left);
+            if (root->kernel == SCALED_LOG) {
+                fprintf(out, ") * ");
+                emit_value(em, Value_new_number(root->k));
+            }
+            fprintf(out, ")");
+            break;
+        case LEFT:
+            emit_operand(em, root->left);
+            break;
+        case RIGHT:
+            emit_operand(em, root->right);
+            break;
+        case GENERAL:
+            return false;
+    }
+    return true;
+}
+
+void emit_value(Emitter *em, Value v)
+{
+    switch (v.type) {
+        case NUMBER:
+            if (v.integral) {
+                fprintf(em->body, "INT64_C(%" PRId64 ")", v.u.i);
+                break;
+            }
+            // Hexadecimal literals carry every bit of the double
+            if (isnan(v.u.d)) fprintf(em->body, "NAN");
+            else if (isinf(v.u.d)) {
+                fprintf(em->body, (v.u.d < 0) ? "(-HUGE_VAL)" : "HUGE_VAL");
+            } else fprintf(em->body, "%a", v.u.d);
+            break;
+        case STRING:
+            emit_literal(em->body, v.u.s, strlen(v.u.s));
+            break;
+        case BOOL:
+            fprintf(em->body, v.u.b ? "1" : "0");
+            break;
+        default:
+            break;
+    }
+}
+
+void emit_literal(FILE *out, const char *text, size_t len)
+{
+    fputc('"', out);
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = text[i];
+        if ((c == '"') || (c == '\\')) fprintf(out, "\\%c", c);
+        else if (c == '\n') fprintf(out, "\\n");
+        else if ((c < ' ') || (c > '~') || (c == '?')) {
+            fprintf(out, "\\%03o", c);
+        } else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+/* Helpers doing exactly what the interpreter does, where C differs */
+void emit_runtime(Emitter *em, FILE *out)
+{
+    if (em->uses_log) {
+        fprintf(out, "static double calc_log(double lhs, double rhs)\n"
+                     "{\n"
+                     "    return log(lhs) / log(rhs);\n"
+                     "}\n\n");
+    }
+    if (em->uses_int) {
+        fprintf(out, "static double calc_int(double lhs, double rhs)\n"
+                     "{\n"
+                     "    return trunc(trunc(lhs) / trunc(rhs)) + 0.0;\n"
+                     "}\n\n");
+    }
+    if (em->uses_power) {
+        fprintf(out, "static int64_t calc_power(int64_t base, int64_t exp)\n"
+                     "{\n"
+                     "    int64_t r = 1;\n"
+                     "    while (1) {\n"
+                     "        if (exp & 1) r *= base;\n"
+                     "        exp >>= 1;\n"
+                     "        if (exp == 0) return r;\n"
+                     "        base *= base;\n"
+                     "    }\n"
+                     "}\n\n");
+    }
+    if (em->uses_chain) {
+        fprintf(out, "static double calc_chain(double x, unsigned n)\n"
+                     "{\n"
+                     "    double r = 1;\n"
+                     "    while (1) {\n"
+                     "        if (n & 1) r *= x;\n"
+                     "        n >>= 1;\n"
+                     "        if (n == 0) return r;\n"
+                     "        x *= x;\n"
+                     "    }\n"
+                     "}\n\n");
+    }
+    if (em->uses_sqrt) {
+        fprintf(out, "static double calc_sqrt(double x)\n"
+                     "{\n"
+                     "    return (x == -HUGE_VAL) ? HUGE_VAL : "
+                     "sqrt(x + 0.0);\n"
+                     "}\n\n");
+    }
+    if (em->uses_cat) {
+        fprintf(out, "static const char *calc_cat(const char *lhs, "
+                     "const char *rhs)\n"
+                     "{\n"
+                     "    size_t l1 = strlen(lhs);\n"
+                     "    size_t l2 = strlen(rhs);\n"
+                     "    char *buf = malloc(l1 + l2 + 1);\n"
+                     "    if (buf == NULL) {\n"
+                     "        perror(\"calc_cat\");\n"
+                     "        exit(EXIT_FAILURE);\n"
+                     "    }\n"
+                     "    memcpy(buf, lhs, l1);\n"
+                     "    memcpy(buf + l1, rhs, l2 + 1);\n"
+                     "    return buf;\n"
+                     "}\n\n");
+    }
+    if (em->uses_print_string) {
+        fprintf(out, "static void calc_print_string(const char *str)\n"
+                     "{\n"
+                     "    for (; *str != '\\0'; ++str) {\n"
+                     "        if (*str != '\\\\') putchar(*str);\n"
+                     "        else if (str[1] == '\\\\') putchar('\\\\');\n"
+                     "    }\n"
+                     "}\n\n");
+    }
+    if (em->uses_print_number) {
+        fprintf(out, "static void calc_print_number(double x)\n"
+                     "{\n"
+                     "    char buf[32];\n"
+                     "    for (int p = 15; ; ++p) {\n"
+                     "        snprintf(buf, sizeof(buf), \"%%.*g\", p, x);\n"
+                     "        if ((p == 17) || (strtod(buf, NULL) == x)) "
+                     "break;\n"
+                     "    }\n"
+                     "    printf(\"= %%s\\n\", buf);\n"
+                     "}\n\n");
+    }
+}
+
+/****************************************************************************/
+
+/* The type AST_evaluate gives root, without evaluating it */
+Type type_of(Emitter *em, AST_Node root)
+{
+    if (root == NULL) return NONE;
+
+    bool leaf = (root->left == NULL) && (root->right == NULL);
+    Type t;
+    Type lhs;
+    Type rhs;
+
+    switch (root->v.type) {
+        case NONE:
+        case INVALID:
+            return root->v.type;
+        case VAR:
+        case LOCAL:
+            t = (root->v.type == LOCAL) ? em->slots[root->v.u.local->slot] :
+                Env_find(em->ctx->env, root->v.u.name).type;
+            if (t == NONE) return leaf ? NONE : INVALID;
+            return leaf ? t : INVALID;
+        case NUMBER:
+        case BOOL:
+        case STRING:
+        case FUNCTION:
+        case BUILTIN:
+            return leaf ? root->v.type : INVALID;
+        case RELAT_OP:
+            lhs = type_of(em, root->left);
+            rhs = type_of(em, root->right);
+            return ((lhs == rhs) && ((lhs == NUMBER) || (lhs == STRING) ||
+                                     (lhs == BOOL))) ? BOOL : INVALID;
+        case OP:
+            if (root->v.u.op == PAREN) return type_of(em, root->right);
+            if (root->v.u.op == COND) {
+                return (taken(em, root) != NULL) ?
+                       type_of(em, taken(em, root)) : INVALID;
+            }
+            if ((root->v.u.op == CALL) || (root->v.u.op == RANGE)) {
+                Value v = AST_evaluate(root, em->ctx, false, NULL);
+                t = v.type;
+                Value_free(&v);
+                return t;
+            }
+            lhs = type_of(em, root->left);
+            rhs = type_of(em, root->right);
+            if (isLogical(root->v.u.op)) {
+                if (lhs != BOOL) return INVALID;
+                return ((rhs == BOOL) || decided(em, root)) ? BOOL : INVALID;
+            }
+            if (lhs != rhs) return INVALID;
+            if (lhs == NUMBER) return NUMBER;
+            if (root->v.u.op != SUM) return INVALID;
+            return ((lhs == STRING) || (lhs == NONE)) ? lhs : INVALID;
+    }
+    return INVALID;
+}
+
+/* The branch of a conditional the interpreter takes, if it gets that far */
+AST_Node taken(Emitter *em, AST_Node root)
+{
+    if ((root->right == NULL) || (type_of(em, root->left) != BOOL)) {
+        return NULL;
+    }
+
+    Value v = AST_evaluate(root->left, em->ctx, false, NULL);
+    AST_Node branch = (v.type != BOOL) ? NULL :
+                      v.u.b ? root->right->left : root->right->right;
+    Value_free(&v);
+    return branch;
+}
+
+/* Whether the left operand of && or || decides its value, so that the */
+/* interpreter never looks at the right one                            */
+bool decided(Emitter *em, AST_Node root)
+{
+    if (root->right == NULL) return false;
+
+    Value v = AST_evaluate(root->left, em->ctx, false, NULL);
+    bool decides = (v.type == BOOL) && (v.u.b == (root->v.u.op == DISJ));
+    Value_free(&v);
+    return decides;
+}
+
+/* Whether the interpreter keeps root's value as an exact integer */
+bool integral(Emitter *em, AST_Node root)
+{
+    Value v = AST_evaluate(root, em->ctx, false, NULL);
+    bool exact = (v.type == NUMBER) && v.integral;
+    Value_free(&v);
+    return exact;
+}
+
+int lookup(Emitter *em, const char *name)
+{
+    for (unsigned i = 0; i < em->nnames; ++i) {
+        if (strcmp(em->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+const char *ctype(Type t, bool exact)
+{
+    switch (t) {
+        case NUMBER:    return exact ? "int64_t " : "double ";
+        case STRING:    return "const char *";
+        case BOOL:      return "int ";
+        default:        return "void *";
+    }
+}
+
+const char *crelop(RELOP rop)
+{
+    switch (rop) {
+        case EQUAL:                 return "==";
+        case NOT_EQUAL:             return "!=";
+        case LESS_THAN:             return "<";
+        case LESS_THAN_OR_EQUAL:    return "<=";
+        case GREATER_THAN:          return ">";
+        case GREATER_THAN_OR_EQUAL: return ">=";
+    }
+    return "==";
+}
+
+FILE *open_buffer(char **text, size_t *size)
+{
+    FILE *fp = open_memstream(text, size);
+    if (fp == NULL) {
+        perror("Emit_c");
+        exit(EXIT_FAILURE);
+    }
+    return fp;
+}
@@ -0,0 +1,20 @@
+#ifndef CALC_EMIT_C_H
+#define CALC_EMIT_C_H 
+
+#include "context.h"
+
+#include <stdio.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Translation of a script into a standalone C99 program that prints *
+ * exactly what interpreting the script with ctx's settings would.   *
+ * The script is interpreted along the way, with its output captured *
+ * rather than printed, to learn each line's types and diagnostics;  *
+ * the arithmetic itself is left to the program.                     *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void Emit_c(CalcContext ctx, FILE *in, FILE *out);
+
+#endif
@@ -69,10 +69,13 @@ Value Env_find(Env e, char *name)
 
 Env Env_bind(Env e, char *name, Value val)
 {
-    if (name == NULL) return e;
-    if (e == NULL) return e;
+    if ((name == NULL) || (e == NULL)) {
+        Value_free(&val);
+        return e;
+    }
 
     Binding tmp;
+    Value found;
 
     switch (val.type) {
         case INVALID:
@@ -80,11 +83,20 @@ Env Env_bind(Env e, char *name, Value val)
         case NUMBER:
         case BOOL:
         case STRING:
+        case FUNCTION:
+        case BUILTIN:
+            // Rebinding within a frame reuses the existing slot
+            if (Binding_rebind(e->bindings, name, val)) break;
             tmp  = Binding_new(name, val);
             e->bindings = Binding_prepend(tmp, e->bindings);
             break;
         case VAR:
-            return Env_bind(e, val.u.name, Value_copy(Env_find(e, val.u.name)));
+            found = Value_copy(Env_find(e, val.u.name));
+            Value_free(&val);
+            return Env_bind(e, name, found);
+        case LOCAL:
+            Value_free(&val);
+            break;
         case OP:
         case RELAT_OP:
             fprintf(stderr, "Attempted to bind operator\n");
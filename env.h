@@ -22,6 +22,8 @@ void Env_free(T *e);
 void Env_free_r(T *e);
 
 Value Env_find(T e, char *name);
+/* Takes ownership of val. A name already bound in e itself (not in the
+ * environments it extends) is updated in place */
 T     Env_bind(T e, char *name, Value val);
 
 void Env_print(T e);
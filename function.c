@@ -0,0 +1,221 @@
+#include "function.h"
+#include "utility.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/****************************************************************************/
+
+typedef struct Memoized {
+    /* NULL marks an empty entry */
+    Value *args;
+    Value result;
+    size_t hash;
+} Memoized;
+
+static size_t hash_args(Value *args, unsigned n);
+static size_t hash_string(const char *s);
+static bool   same_args(Value *a, Value *b, unsigned n);
+static void   grow(Function fn);
+
+/****************************************************************************/
+
+Function Function_new(char *name, Scope params, AST_Node body, Scope where,
+                      bool memo)
+{
+    Function fn = malloc(sizeof(*fn));
+    if (fn == NULL) {
+        perror("Function_new");
+        exit(EXIT_FAILURE);
+    }
+    fn->name = copy_string(name);
+    fn->params = params;
+    fn->body = body;
+    fn->where = where;
+    fn->memo = memo;
+    fn->refs = 1;
+    fn->results = NULL;
+    fn->capacity = 0;
+    fn->size = 0;
+
+    return fn;
+}
+
+Function Function_share(Function fn)
+{
+    if (fn != NULL) ++fn->refs;
+    return fn;
+}
+
+void Function_free(Function *fn)
+{
+    if (fn == NULL || *fn == NULL) return;
+
+    if (--(*fn)->refs == 0) {
+        unsigned n = Function_arity(*fn);
+        for (size_t i = 0; i < (*fn)->capacity; ++i) {
+            Memoized *m = &(*fn)->results[i];
+            if (m->args == NULL) continue;
+            for (unsigned j = 0; j < n; ++j) Value_free(&m->args[j]);
+            free(m->args);
+            Value_free(&m->result);
+        }
+        free((*fn)->results);
+        free((*fn)->name);
+        Scope_free(&(*fn)->params);
+        AST_free(&(*fn)->body);
+        Scope_free(&(*fn)->where);
+        free(*fn);
+    }
+    *fn = NULL;
+}
+
+unsigned Function_arity(Function fn)
+{
+    return fn->params->size;
+}
+
+Value *Function_recall(Function fn, Value *args)
+{
+    if (fn->size == 0) return NULL;
+
+    unsigned n = Function_arity(fn);
+    size_t h = hash_args(args, n);
+    size_t mask = fn->capacity - 1;
+    for (size_t i = h & mask; fn->results[i].args != NULL;
+            i = (i + 1) & mask) {
+        Memoized *m = &fn->results[i];
+        if ((m->hash == h) && same_args(m->args, args, n)) return &m->result;
+    }
+    return NULL;
+}
+
+unsigned Function_remember(Function fn, Value *args, Value result)
+{
+    unsigned allocations = 0;
+    if (4 * (fn->size + 1) > 3 * fn->capacity) {
+        grow(fn);
+        ++allocations;
+    }
+
+    unsigned n = Function_arity(fn);
+    size_t h = hash_args(args, n);
+    size_t mask = fn->capacity - 1;
+    size_t i = h & mask;
+    for (; fn->results[i].args != NULL; i = (i + 1) & mask) {
+        if ((fn->results[i].hash == h) &&
+                same_args(fn->results[i].args, args, n)) {
+            return allocations;
+        }
+    }
+
+    Memoized *m = &fn->results[i];
+    m->args = malloc(n * sizeof(*m->args));
+    if (m->args == NULL) {
+        perror("Function_remember");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned j = 0; j < n; ++j) m->args[j] = Value_copy(args[j]);
+    m->result = Value_copy(result);
+    m->hash = h;
+    ++fn->size;
+    return allocations + 1;
+}
+
+void Function_print(Function fn, FILE *out)
+{
+    fprintf(out, "<Function %s(", fn->name);
+    for (unsigned i = 0; i < Function_arity(fn); ++i) {
+        fprintf(out, "%s%s", (i > 0) ? ", " : "", fn->params->names[i]);
+    }
+    fprintf(out, ")>");
+}
+
+/****************************************************************************/
+
+/* Numbers hash by their bits, so that 0 and -0 stay apart, as do equal */
+/* integers and doubles, whose results may differ in exactness          */
+size_t hash_args(Value *args, unsigned n)
+{
+    size_t h = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        uint64_t bits = 0;
+        size_t k = (size_t) args[i].type * 0x9E3779B97F4A7C15u;
+        switch (args[i].type) {
+            case NUMBER:
+                memcpy(&bits, &args[i].u, sizeof(bits));
+                k ^= (size_t) (bits ^ (bits >> 29)) + args[i].integral;
+                break;
+            case STRING:    k ^= hash_string(args[i].u.s); break;
+            case BOOL:      k ^= args[i].u.b; break;
+            case FUNCTION:  k ^= (size_t) (uintptr_t) args[i].u.fn; break;
+            case BUILTIN:
+                k ^= (size_t) (uintptr_t) args[i].u.builtin;
+                break;
+            default:        break;
+        }
+        h = (h * 31) + k;
+    }
+    return h ^ (h >> 17);
+}
+
+/* FNV-1a */
+size_t hash_string(const char *s)
+{
+    size_t h = 2166136261u;
+    for (; *s != '\0'; ++s) h = (h ^ (unsigned char) *s) * 16777619u;
+    return h;
+}
+
+bool same_args(Value *a, Value *b, unsigned n)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        if (a[i].type != b[i].type) return false;
+        switch (a[i].type) {
+            case NUMBER:
+                if ((a[i].integral != b[i].integral) ||
+                        (memcmp(&a[i].u, &b[i].u, sizeof(a[i].u.d)) != 0)) {
+                    return false;
+                }
+                break;
+            case STRING:
+                if (strcmp(a[i].u.s, b[i].u.s) != 0) return false;
+                break;
+            case BOOL:
+                if (a[i].u.b != b[i].u.b) return false;
+                break;
+            case FUNCTION:
+                if (a[i].u.fn != b[i].u.fn) return false;
+                break;
+            case BUILTIN:
+                if (a[i].u.builtin != b[i].u.builtin) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void grow(Function fn)
+{
+    size_t capacity = (fn->capacity == 0) ? 16 : 2 * fn->capacity;
+    Memoized *results = calloc(capacity, sizeof(*results));
+    if (results == NULL) {
+        perror("Function_remember");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t j = 0; j < fn->capacity; ++j) {
+        if (fn->results[j].args == NULL) continue;
+        size_t i = fn->results[j].hash & (capacity - 1);
+        while (results[i].args != NULL) i = (i + 1) & (capacity - 1);
+        results[i] = fn->results[j];
+    }
+    free(fn->results);
+    fn->results = results;
+    fn->capacity = capacity;
+}
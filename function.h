@@ -0,0 +1,66 @@
+#ifndef CALC_USER_FUNCTION_H
+#define CALC_USER_FUNCTION_H
+
+#include "ast.h"
+#include "scope.h"
+#include "value.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define T Function
+typedef struct T *T;
+
+struct Memoized;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * A function defined by let f(x, y) = .... Its body reads its       *
+ * parameters as locals of a frame pushed for each call, one level   *
+ * outside the frame of its where clause if it has one. Values share *
+ * a function rather than copying it. A memoizing function keeps the *
+ * result of each call by the values of its arguments.               *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct T {
+    char *name;
+    /* Only the names are used; each call binds the arguments in order */
+    Scope params;
+    AST_Node body;
+    Scope where;
+    bool memo;
+
+    /* Values holding the function */
+    unsigned refs;
+
+    /* Open addressed table of results */
+    struct Memoized *results;
+    size_t capacity;
+    size_t size;
+};
+
+/* Takes ownership of params, body and where, whose names are resolved */
+/* to locals already; name is copied                                   */
+T    Function_new(char *name, Scope params, AST_Node body, Scope where,
+                  bool memo);
+/* Another hold on fn */
+T    Function_share(T fn);
+/* Let go of fn, freeing it with the last hold */
+void Function_free(T *fn);
+
+unsigned Function_arity(T fn);
+
+/* The result remembered for args, one per parameter, if any. The pointer */
+/* is only valid until the next Function_remember                          */
+Value *Function_recall(T fn, Value *args);
+/* Remember result for args; both are copied. Returns how many blocks */
+/* of memory that took                                                */
+unsigned Function_remember(T fn, Value *args, Value result);
+
+/* As <Function f(x, y)> */
+void Function_print(T fn, FILE *out);
+
+#undef T
+#endif
@@ -0,0 +1,576 @@
+/* mmap's anonymous mappings are not part of POSIX proper */
+#define _DEFAULT_SOURCE
+
+#include "jit.h"
+#include "reduce.h"
+#include "builtin.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/****************************************************************************/
+
+typedef double compiled(const double *inputs, double *where);
+
+struct Jit {
+    compiled *fn;
+    void *code;
+    size_t code_size;
+    /* Scratch space for the where clause */
+    double *where;
+};
+
+#if defined(__x86_64__)
+
+typedef struct Emitter {
+    unsigned char *bytes;
+    size_t size;
+    size_t capacity;
+
+    unsigned ninputs;
+    unsigned nwhere;
+    Scope where;
+    /* The values of where bindings made of literals alone, NONE otherwise */
+    Value *consts;
+    /* Where bindings already computed, which may be referred to */
+    bool *visible;
+
+    unsigned spills;
+    unsigned max_spills;
+} Emitter;
+
+static bool checked(Emitter *em, AST_Node root);
+static bool checked_call(Emitter *em, AST_Node root);
+static bool is_leaf(AST_Node root);
+static bool fold(Emitter *em, AST_Node root, Value *v);
+static bool fold_call(Emitter *em, AST_Node root, Value *v);
+static void gen(Emitter *em, AST_Node root);
+static void gen_operands(Emitter *em, AST_Node lhs, AST_Node rhs);
+static void gen_call(Emitter *em, AST_Node root);
+static void gen_leaf(Emitter *em, AST_Node leaf, unsigned xmm);
+static void gen_constant(Emitter *em, double d, unsigned xmm);
+static void gen_op(Emitter *em, AST_Node root);
+
+static void emit(Emitter *em, const unsigned char *bytes, size_t n);
+static void emit_u32(Emitter *em, uint32_t v);
+static void emit_u64(Emitter *em, uint64_t v);
+static uint32_t spill_offset(unsigned spill);
+
+static double jit_log(double lhs, double rhs);
+static double jit_int(double lhs, double rhs);
+
+#endif
+
+/****************************************************************************/
+
+#if defined(__x86_64__)
+
+Jit Jit_compile(Statement st, unsigned ninputs)
+{
+    if ((st == NULL) || (st->root == NULL)) return NULL;
+
+    Emitter em = {NULL, 0, 0, ninputs, 0, st->where, NULL, NULL, 0, 0};
+    if (st->where != NULL) em.nwhere = st->where->size;
+
+    // Bindings are computed in dependency order, so each may only refer to
+    // those before it there
+    em.visible = calloc(em.nwhere + 1, sizeof(*em.visible));
+    if (em.visible == NULL) {
+        perror("Jit_compile");
+        exit(EXIT_FAILURE);
+    }
+    bool ok = true;
+    for (unsigned k = 0; ok && (k < em.nwhere); ++k) {
+        unsigned i = st->where->order[k];
+        ok = checked(&em, st->where->exprs[i]);
+        em.visible[i] = true;
+    }
+    ok = ok && checked(&em, st->root);
+    free(em.visible);
+    if (!ok) return NULL;
+
+    em.consts = malloc((em.nwhere + 1) * sizeof(*em.consts));
+    if (em.consts == NULL) {
+        perror("Jit_compile");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned k = 0; k < em.nwhere; ++k) {
+        unsigned i = st->where->order[k];
+        if (!fold(&em, st->where->exprs[i], &em.consts[i])) {
+            em.consts[i] = NOTHING;
+        }
+    }
+
+    // push rbp; mov rbp, rsp; push rbx; push r12
+    // mov rbx, rdi; mov r12, rsi; sub rsp, frame
+    static const unsigned char PROLOGUE[] = {
+        0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54,
+        0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x48, 0x81, 0xEC
+    };
+    // lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp; ret
+    static const unsigned char EPILOGUE[] = {
+        0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B, 0x5D, 0xC3
+    };
+    // movsd [r12 + disp32], xmm0
+    static const unsigned char STORE_WHERE[] = {
+        0xF2, 0x41, 0x0F, 0x11, 0x84, 0x24
+    };
+
+    emit(&em, PROLOGUE, sizeof(PROLOGUE));
+    size_t frame_at = em.size;
+    emit_u32(&em, 0);
+
+    for (unsigned k = 0; k < em.nwhere; ++k) {
+        unsigned i = st->where->order[k];
+        gen(&em, st->where->exprs[i]);
+        emit(&em, STORE_WHERE, sizeof(STORE_WHERE));
+        emit_u32(&em, 8 * i);
+    }
+    gen(&em, st->root);
+    emit(&em, EPILOGUE, sizeof(EPILOGUE));
+    free(em.consts);
+
+    // Spill slots sit below the saved registers. With those and rbp pushed
+    // rsp is 16-byte aligned, and stays so for calls out
+    uint32_t frame = ((em.max_spills * 8) + 15) & ~15u;
+    memcpy(em.bytes + frame_at, &frame, sizeof(frame));
+
+    Jit j = malloc(sizeof(*j));
+    if (j == NULL) {
+        perror("Jit_compile");
+        exit(EXIT_FAILURE);
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    j->code_size = ((em.size + page - 1) / page) * page;
+    j->code = mmap(NULL, j->code_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (j->code == MAP_FAILED) {
+        free(em.bytes);
+        free(j);
+        return NULL;
+    }
+    memcpy(j->code, em.bytes, em.size);
+    free(em.bytes);
+    if (mprotect(j->code, j->code_size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(j->code, j->code_size);
+        free(j);
+        return NULL;
+    }
+    memcpy(&j->fn, &j->code, sizeof(j->fn));
+
+    j->where = malloc((em.nwhere + 1) * sizeof(*j->where));
+    if (j->where == NULL) {
+        perror("Jit_compile");
+        exit(EXIT_FAILURE);
+    }
+
+    return j;
+}
+
+void Jit_free(Jit *j)
+{
+    if (j == NULL || *j == NULL) return;
+    munmap((*j)->code, (*j)->code_size);
+    free((*j)->where);
+    free(*j);
+    *j = NULL;
+}
+
+#else
+
+Jit Jit_compile(Statement st, unsigned ninputs)
+{
+    (void) st;
+    (void) ninputs;
+    return NULL;
+}
+
+void Jit_free(Jit *j)
+{
+    (void) j;
+}
+
+#endif
+
+double Jit_run(Jit j, const double *inputs)
+{
+    return j->fn(inputs, j->where);
+}
+
+/****************************************************************************/
+
+#if defined(__x86_64__)
+
+/* Whether root can be compiled. Mirrors what AST_evaluate accepts without */
+/* error when every input is a number                                      */
+bool checked(Emitter *em, AST_Node root)
+{
+    if (root == NULL) return false;
+
+    switch (root->v.type) {
+        case NUMBER:
+            return is_leaf(root);
+        case LOCAL:
+            if (!is_leaf(root)) return false;
+            if ((em->nwhere > 0) && (root->v.u.local->depth == 0)) {
+                return em->visible[root->v.u.local->slot];
+            }
+            return (root->v.u.local->depth == ((em->nwhere > 0) ? 1 : 0)) &&
+                   (root->v.u.local->slot < em->ninputs);
+        case OP:
+            if (root->v.u.op == PAREN) return checked(em, root->right);
+            if (root->v.u.op == CALL) return checked_call(em, root);
+            if ((root->v.u.op == LITERAL) || isLogical(root->v.u.op) ||
+                    (root->v.u.op == COND) || (root->v.u.op == RANGE) ||
+                    (root->left == NULL) || (root->right == NULL)) {
+                return false;
+            }
+            return checked(em, root->left) && checked(em, root->right);
+        default:
+            return false;
+    }
+}
+
+/* Only the library's functions are called from compiled code, with as */
+/* many arguments as they take. An input applied to one argument is a  */
+/* number, and so multiplies it                                        */
+bool checked_call(Emitter *em, AST_Node root)
+{
+    if (root->left->v.type != BUILTIN) {
+        return (root->left->v.type == LOCAL) && checked(em, root->left) &&
+               (root->right != NULL) && (root->right->right == NULL) &&
+               (root->right->v.type == OP) && (root->right->v.u.op == ARG) &&
+               checked(em, root->right->left);
+    }
+
+    unsigned n = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++n) {
+        if ((arg->v.type != OP) || (arg->v.u.op != ARG) ||
+                !checked(em, arg->left)) {
+            return false;
+        }
+    }
+    return n == root->left->v.u.builtin->arity;
+}
+
+bool is_leaf(AST_Node root)
+{
+    return (root->left == NULL) && (root->right == NULL);
+}
+
+/* Subtrees of literals alone are worked out here, with the interpreter's */
+/* own arithmetic, so that integers combine exactly as they would there  */
+bool fold(Emitter *em, AST_Node root, Value *v)
+{
+    Value lhs;
+    Value rhs;
+
+    switch (root->v.type) {
+        case NUMBER:
+            *v = root->v;
+            return true;
+        case LOCAL:
+            if ((em->nwhere == 0) || (root->v.u.local->depth != 0)) {
+                return false;
+            }
+            *v = em->consts[root->v.u.local->slot];
+            return v->type == NUMBER;
+        case OP:
+            if (root->v.u.op == PAREN) return fold(em, root->right, v);
+            if (root->v.u.op == CALL) return fold_call(em, root, v);
+            if (!fold(em, root->left, &lhs) || !fold(em, root->right, &rhs)) {
+                return false;
+            }
+            *v = Reduce_combine(root, lhs, rhs);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool fold_call(Emitter *em, AST_Node root, Value *v)
+{
+    if (root->left->v.type != BUILTIN) {
+        Value f;
+        Value arg;
+        if (!fold(em, root->left, &f) || !fold(em, root->right->left, &arg)) {
+            return false;
+        }
+        *v = Value_combine(f, PROD, arg);
+        return true;
+    }
+
+    Value args[2];
+    unsigned i = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++i) {
+        if (!fold(em, arg->left, &args[i])) return false;
+    }
+    *v = Builtin_call(root->left->v.u.builtin, args);
+    return true;
+}
+
+/* Leave the value of root in xmm0 */
+void gen(Emitter *em, AST_Node root)
+{
+    while ((root->v.type == OP) && (root->v.u.op == PAREN)) {
+        root = root->right;
+    }
+    if (root->v.type != OP) {
+        gen_leaf(em, root, 0);
+        return;
+    }
+    Value folded;
+    if (fold(em, root, &folded)) {
+        gen_constant(em, Value_number(folded), 0);
+        return;
+    }
+    if (root->v.u.op == CALL) {
+        gen_call(em, root);
+        return;
+    }
+
+    gen_operands(em, root->left, root->right);
+    gen_op(em, root);
+}
+
+/* Leave the value of lhs in xmm0 and of rhs in xmm1 */
+void gen_operands(Emitter *em, AST_Node lhs, AST_Node rhs)
+{
+    // movsd xmm0, [rbp - disp32]; movsd [rbp - disp32], xmm0
+    static const unsigned char LOAD_SPILL[] = {0xF2, 0x0F, 0x10, 0x85};
+    static const unsigned char STORE_SPILL[] = {0xF2, 0x0F, 0x11, 0x85};
+    // movapd xmm1, xmm0
+    static const unsigned char MOVE_01[] = {0x66, 0x0F, 0x28, 0xC8};
+
+    while ((rhs->v.type == OP) && (rhs->v.u.op == PAREN)) rhs = rhs->right;
+
+    if (rhs->v.type != OP) {
+        gen(em, lhs);
+        gen_leaf(em, rhs, 1);
+    } else {
+        while ((lhs->v.type == OP) && (lhs->v.u.op == PAREN)) {
+            lhs = lhs->right;
+        }
+        if (lhs->v.type != OP) {
+            gen(em, rhs);
+            emit(em, MOVE_01, sizeof(MOVE_01));
+            gen_leaf(em, lhs, 0);
+        } else {
+            // Evaluated left to right, as the interpreter does
+            unsigned spill = em->spills++;
+            if (em->spills > em->max_spills) em->max_spills = em->spills;
+            gen(em, lhs);
+            emit(em, STORE_SPILL, sizeof(STORE_SPILL));
+            emit_u32(em, spill_offset(spill));
+            gen(em, rhs);
+            emit(em, MOVE_01, sizeof(MOVE_01));
+            emit(em, LOAD_SPILL, sizeof(LOAD_SPILL));
+            emit_u32(em, spill_offset(spill));
+            --em->spills;
+        }
+    }
+}
+
+/* Arguments go in xmm0 and xmm1, as the C calling convention has them, */
+/* and the function held by the call is called directly. An input        */
+/* applied to an argument is multiplied by it instead                    */
+void gen_call(Emitter *em, AST_Node root)
+{
+    // mov rax, imm64; call rax
+    static const unsigned char MOV_RAX[] = {0x48, 0xB8};
+    static const unsigned char CALL_RAX[] = {0xFF, 0xD0};
+    // mulsd xmm0, xmm1
+    static const unsigned char MUL_01[] = {0xF2, 0x0F, 0x59, 0xC1};
+
+    if (root->left->v.type != BUILTIN) {
+        gen_operands(em, root->left, root->right->left);
+        emit(em, MUL_01, sizeof(MUL_01));
+        return;
+    }
+
+    const Builtin *b = root->left->v.u.builtin;
+    AST_Node args = root->right;
+    uint64_t fn;
+    if (b->arity == 1) {
+        gen(em, args->left);
+        fn = (uint64_t) (uintptr_t) b->unary;
+    } else {
+        gen_operands(em, args->left, args->right->left);
+        fn = (uint64_t) (uintptr_t) b->binary;
+    }
+    emit(em, MOV_RAX, sizeof(MOV_RAX));
+    emit_u64(em, fn);
+    emit(em, CALL_RAX, sizeof(CALL_RAX));
+}
+
+/* Load a number or local into xmm0 or xmm1 */
+void gen_leaf(Emitter *em, AST_Node leaf, unsigned xmm)
+{
+    if (leaf->v.type == NUMBER) {
+        gen_constant(em, Value_number(leaf->v), xmm);
+        return;
+    }
+
+    unsigned char reg = (unsigned char) (xmm << 3);
+    unsigned slot = leaf->v.u.local->slot;
+    if ((em->nwhere > 0) && (leaf->v.u.local->depth == 0)) {
+        // movsd xmm, [r12 + disp32]
+        unsigned char load[] = {0xF2, 0x41, 0x0F, 0x10, 0x84 | reg, 0x24};
+        emit(em, load, sizeof(load));
+    } else {
+        // movsd xmm, [rbx + disp32]
+        unsigned char load[] = {0xF2, 0x0F, 0x10, 0x83 | reg};
+        emit(em, load, sizeof(load));
+    }
+    emit_u32(em, 8 * slot);
+}
+
+void gen_constant(Emitter *em, double d, unsigned xmm)
+{
+    // mov rax, imm64; movq xmm, rax
+    static const unsigned char MOV_RAX[] = {0x48, 0xB8};
+    unsigned char movq[] = {0x66, 0x48, 0x0F, 0x6E, 0xC0 | (xmm << 3)};
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    emit(em, MOV_RAX, sizeof(MOV_RAX));
+    emit_u64(em, bits);
+    emit(em, movq, sizeof(movq));
+}
+
+/* xmm0 = xmm0 op xmm1, by way of root's kernel */
+void gen_op(Emitter *em, AST_Node root)
+{
+    // mulsd xmm1, xmm0; mulsd xmm0, xmm0; mulsd xmm0, xmm1
+    static const unsigned char MUL_10[] = {0xF2, 0x0F, 0x59, 0xC8};
+    static const unsigned char MUL_00[] = {0xF2, 0x0F, 0x59, 0xC0};
+    static const unsigned char MUL_01[] = {0xF2, 0x0F, 0x59, 0xC1};
+    // movapd xmm0, xmm1
+    static const unsigned char MOVE_10[] = {0x66, 0x0F, 0x28, 0xC1};
+    // mov rax, imm64; call rax
+    static const unsigned char MOV_RAX[] = {0x48, 0xB8};
+    static const unsigned char CALL_RAX[] = {0xFF, 0xD0};
+
+    unsigned char arith[] = {0xF2, 0x0F, 0x00, 0xC1};
+    double (*fn)(double, double) = NULL;
+    double (*unary)(double) = NULL;
+
+    // Operands are never both integers here, so kernels always apply
+    switch (root->kernel) {
+        case POWER:
+            // As Reduce_power: xmm1 is the product so far, xmm0 the square
+            gen_constant(em, 1, 1);
+            for (unsigned n = (unsigned) root->k; ; ) {
+                if (n & 1) emit(em, MUL_10, sizeof(MUL_10));
+                n >>= 1;
+                if (n == 0) break;
+                emit(em, MUL_00, sizeof(MUL_00));
+            }
+            emit(em, MOVE_10, sizeof(MOVE_10));
+            return;
+        case SQUARE_ROOT:   unary = Reduce_sqrt; break;
+        case LOG2:          unary = log2; break;
+        case LOG10:         unary = log10; break;
+        case SCALED_LOG:    unary = log; break;
+        case LEFT:          return;
+        case RIGHT:
+            emit(em, MOVE_10, sizeof(MOVE_10));
+            return;
+        case GENERAL:       break;
+    }
+    if (unary != NULL) {
+        emit(em, MOV_RAX, sizeof(MOV_RAX));
+        emit_u64(em, (uint64_t) (uintptr_t) unary);
+        emit(em, CALL_RAX, sizeof(CALL_RAX));
+        if (root->kernel == SCALED_LOG) {
+            gen_constant(em, root->k, 1);
+            emit(em, MUL_01, sizeof(MUL_01));
+        }
+        return;
+    }
+
+    switch (root->v.u.op) {
+        case SUM:   arith[2] = 0x58; break;
+        case DIFF:  arith[2] = 0x5C; break;
+        case PROD:  arith[2] = 0x59; break;
+        case QUOT:  arith[2] = 0x5E; break;
+        case EXP:   fn = pow; break;
+        case LOG:   fn = jit_log; break;
+        case MOD:   fn = fmod; break;
+        case INT:   fn = jit_int; break;
+        case LITERAL:
+        case PAREN:
+        case CONJ:
+        case DISJ:
+        case COND:
+        case BRANCHES:
+        case CALL:
+        case ARG:
+        case RANGE:
+            return;
+    }
+
+    if (fn == NULL) {
+        emit(em, arith, sizeof(arith));
+    } else {
+        emit(em, MOV_RAX, sizeof(MOV_RAX));
+        emit_u64(em, (uint64_t) (uintptr_t) fn);
+        emit(em, CALL_RAX, sizeof(CALL_RAX));
+    }
+}
+
+void emit(Emitter *em, const unsigned char *bytes, size_t n)
+{
+    if (em->size + n > em->capacity) {
+        em->capacity = 2 * (em->capacity + n);
+        em->bytes = realloc(em->bytes, em->capacity);
+        if (em->bytes == NULL) {
+            perror("Jit_compile");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(em->bytes + em->size, bytes, n);
+    em->size += n;
+}
+
+/* Immediates and displacements are little-endian */
+void emit_u32(Emitter *em, uint32_t v)
+{
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = (v >> (8 * i)) & 0xFF;
+    emit(em, bytes, sizeof(bytes));
+}
+
+void emit_u64(Emitter *em, uint64_t v)
+{
+    emit_u32(em, (uint32_t) v);
+    emit_u32(em, (uint32_t) (v >> 32));
+}
+
+/* rbx and r12 are saved just below rbp */
+uint32_t spill_offset(unsigned spill)
+{
+    return (uint32_t) -(int32_t) (24 + 8 * spill);
+}
+
+/* The same arithmetic as Value_combine */
+double jit_log(double lhs, double rhs)
+{
+    return log(lhs) / log(rhs);
+}
+
+double jit_int(double lhs, double rhs)
+{
+    return trunc(trunc(lhs) / trunc(rhs)) + 0.0;
+}
+
+#endif
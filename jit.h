@@ -0,0 +1,28 @@
+#ifndef CALC_JIT_H
+#define CALC_JIT_H 
+
+#include "statement.h"
+
+#define T Jit
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Native x86-64 code for statements that only do arithmetic. Every  *
+ * leaf must be a number or a local: either one of ninputs inputs,   *
+ * which sit one frame outside the where clause (or in the innermost *
+ * frame if there is none), or a where binding defined before the    *
+ * one using it. The result is bit-for-bit what AST_evaluate gives   *
+ * when all of the inputs are numbers.                               *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* NULL if st has any other shape, or on other architectures */
+T      Jit_compile(Statement st, unsigned ninputs);
+void   Jit_free(T *j);
+
+/* Not safe to call on the same j from two threads at once */
+double Jit_run(T j, const double *inputs);
+
+#undef T
+#endif
@@ -0,0 +1,208 @@
+
+#include "libcalc.h"
+#include "parse.h"
+#include "basis.h"
+#include "context.h"
+#include "statement.h"
+#include "scope.h"
+#include "jit.h"
+#include "utility.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string.h>
+
+/****************************************************************************/
+
+struct calc_expr {
+    Statement st;
+    /* Diagnostics are discarded; failures surface as CALC_ERROR */
+    CalcContext ctx;
+
+    /* Free variables, evaluated as a frame enclosing the where clause */
+    Scope inputs;
+    Value *defaults;
+    /* The binding each input was found in on the previous call */
+    const char **matched;
+    size_t *matched_at;
+
+    /* Native code for the expression, if it is purely arithmetic */
+    Jit jit;
+    double *numbers;
+
+    Value result;
+};
+
+/****************************************************************************/
+
+static Value from_calc_value(calc_value v);
+static calc_value to_calc_value(Value v);
+
+/****************************************************************************/
+
+calc_expr *calc_compile(const char *src)
+{
+    if (src == NULL) return NULL;
+
+    char *line = copy_string(src);
+    CalcContext ctx = Context_new(add_basis(Env_new()), NULL, NULL);
+    Statement st = parse(line, ctx);
+    free(line);
+
+    if (!Statement_well_formed(st)) {
+        Statement_free(&st);
+        Context_free(&ctx);
+        return NULL;
+    }
+
+    calc_expr *expr = malloc(sizeof(*expr));
+    if (expr == NULL) {
+        perror("calc_compile");
+        exit(EXIT_FAILURE);
+    }
+    expr->st = st;
+    expr->ctx = ctx;
+    expr->inputs = Scope_new();
+    expr->result = NOTHING;
+
+    Statement_inputs(st, expr->inputs);
+    Statement_resolve(st, expr->inputs);
+
+    unsigned n = expr->inputs->size;
+    expr->defaults = malloc((n + 1) * sizeof(*expr->defaults));
+    expr->matched = malloc((n + 1) * sizeof(*expr->matched));
+    expr->matched_at = malloc((n + 1) * sizeof(*expr->matched_at));
+    expr->numbers = malloc((n + 1) * sizeof(*expr->numbers));
+    if ((expr->defaults == NULL) || (expr->matched == NULL) ||
+            (expr->matched_at == NULL) || (expr->numbers == NULL)) {
+        perror("calc_compile");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        expr->defaults[i] = Env_find(ctx->env, expr->inputs->names[i]);
+        expr->matched[i] = NULL;
+        expr->matched_at[i] = 0;
+    }
+    expr->jit = Jit_compile(st, n);
+
+    return expr;
+}
+
+void calc_free(calc_expr *expr)
+{
+    if (expr == NULL) return;
+
+    Value_free(&expr->result);
+    Statement_free(&expr->st);
+    Scope_free(&expr->inputs);
+    Context_free(&expr->ctx);
+    free(expr->defaults);
+    free(expr->matched);
+    free(expr->matched_at);
+    free(expr->numbers);
+    Jit_free(&expr->jit);
+    free(expr);
+}
+
+size_t calc_nvars(const calc_expr *expr)
+{
+    return (expr == NULL) ? 0 : expr->inputs->size;
+}
+
+const char *calc_varname(const calc_expr *expr, size_t i)
+{
+    if ((expr == NULL) || (i >= expr->inputs->size)) return NULL;
+    return expr->inputs->names[i];
+}
+
+calc_value calc_eval(calc_expr *expr, const calc_binding *bindings, size_t n)
+{
+    calc_value error = {CALC_ERROR, {0}};
+    if (expr == NULL) return error;
+
+    Scope inputs = expr->inputs;
+    bool numeric = (expr->jit != NULL);
+
+    for (unsigned i = 0; i < inputs->size; ++i) {
+        size_t at = expr->matched_at[i];
+        if ((expr->matched[i] == NULL) || (at >= n) ||
+                (bindings[at].name != expr->matched[i])) {
+            expr->matched[i] = NULL;
+            for (at = 0; at < n; ++at) {
+                if ((bindings[at].name != NULL) &&
+                        (strcmp(bindings[at].name, inputs->names[i]) == 0)) {
+                    expr->matched[i] = bindings[at].name;
+                    expr->matched_at[i] = at;
+                    break;
+                }
+            }
+        }
+
+        if (expr->matched[i] != NULL) {
+            calc_value v = bindings[expr->matched_at[i]].value;
+            numeric = numeric && (v.type == CALC_NUMBER);
+            expr->numbers[i] = v.u.number;
+        } else {
+            numeric = numeric && (expr->defaults[i].type == NUMBER);
+            expr->numbers[i] = Value_number(expr->defaults[i]);
+        }
+    }
+
+    Value_free(&expr->result);
+
+    // Arithmetic on numbers alone always succeeds, so needs no interpreter
+    if (numeric) {
+        expr->result = Value_new_number(Jit_run(expr->jit, expr->numbers));
+        return to_calc_value(expr->result);
+    }
+
+    CalcContext ctx = expr->ctx;
+    Stack_push(ctx->stack, inputs->size);
+    for (unsigned i = 0; i < inputs->size; ++i) {
+        *Stack_slot(ctx->stack, 0, i) = (expr->matched[i] != NULL) ?
+            from_calc_value(bindings[expr->matched_at[i]].value) :
+            Value_copy(expr->defaults[i]);
+    }
+    expr->result = Statement_eval(expr->st, ctx, false, NULL);
+    Stack_pop(ctx->stack);
+
+    return to_calc_value(expr->result);
+}
+
+/****************************************************************************/
+
+Value from_calc_value(calc_value v)
+{
+    switch (v.type) {
+        case CALC_NUMBER:   return Value_new_number(v.u.number);
+        case CALC_STRING:   return Value_new_string(v.u.string);
+        case CALC_BOOL:     return Value_new_bool(v.u.boolean != 0);
+        case CALC_ERROR:    return NOTHING;
+    }
+    // Compiler dummy
+    return NOTHING;
+}
+
+calc_value to_calc_value(Value v)
+{
+    calc_value r = {CALC_ERROR, {0}};
+
+    switch (v.type) {
+        case NUMBER:
+            r.type = CALC_NUMBER;
+            r.u.number = Value_number(v);
+            break;
+        case STRING:
+            r.type = CALC_STRING;
+            r.u.string = v.u.s;
+            break;
+        case BOOL:
+            r.type = CALC_BOOL;
+            r.u.boolean = v.u.b;
+            break;
+        default:
+            break;
+    }
+    return r;
+}
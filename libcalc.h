@@ -0,0 +1,63 @@
+#ifndef CALC_LIBRARY_H
+#define CALC_LIBRARY_H 
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Embedding interface. An expression is parsed once by calc_compile *
+ * and may then be evaluated any number of times against different   *
+ * variable values without being parsed again.                       *
+ *                                                                   *
+ * Handles are independent of each other but a single handle must   *
+ * not be evaluated from two threads at once.                        *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef struct calc_expr calc_expr;
+
+typedef enum calc_type {
+    CALC_ERROR = -1, CALC_NUMBER, CALC_STRING, CALC_BOOL
+} calc_type;
+
+typedef struct calc_value {
+    calc_type type;
+    union {
+        double number;
+        const char *string;
+        int boolean;
+    } u;
+} calc_value;
+
+typedef struct calc_binding {
+    const char *name;
+    calc_value value;
+} calc_binding;
+
+/* Returns NULL if src is not a well-formed expression. A where clause  */
+/* is allowed; a leading let is evaluated but binds nothing.            */
+calc_expr *calc_compile(const char *src);
+void       calc_free(calc_expr *expr);
+
+/* Names the expression reads that its where clause does not bind, in */
+/* order of first use. Those not supplied to calc_eval fall back to   */
+/* the built-in constants (PI, E, ...)                                 */
+size_t      calc_nvars(const calc_expr *expr);
+const char *calc_varname(const calc_expr *expr, size_t i);
+
+/* Evaluate against the n given bindings. Names are matched against     */
+/* those of the previous call by pointer first, so reusing one bindings */
+/* array avoids string comparisons. A string result stays valid until   */
+/* the next calc_eval or calc_free on the same handle.                  */
+calc_value calc_eval(calc_expr *expr, const calc_binding *bindings,
+                     size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,7 +3,12 @@
 #include "value.h"
 #include "ast.h"
 #include "utility.h"
-#include "subexp.h"
+#include "context.h"
+#include "script.h"
+#include "server.h"
+#include "emit.h"
+#include "columns.h"
+#include "profile.h"
 
 #include "tokenize.h"
 #include "parse.h"
@@ -14,24 +19,45 @@
 #include <stdbool.h>
 #include <string.h>
 
-typedef enum VERBOSITY {QUIET, NORMAL, VERBOSE} VERBOSITY;
-static VERBOSITY verbosity = NORMAL;
-
-typedef enum ECHO {YES, NO} ECHO;
-static ECHO echo = YES;
-
 static const char *HELPME = "-q: Quiet - Suppress most output\n"
                             "-v: Verbose - Produce extra output\n"
-                            "--no-echo: No echo - Don't echo parsed expression";
+                            "--no-echo: No echo - Don't echo parsed "
+                            "expression\n"
+                            "--shortest: Shortest - Print numbers with as "
+                            "many digits as it takes to read them back "
+                            "exactly\n"
+                            "--output=binary: Binary output - Write results "
+                            "as typed records, without prompts or echo\n"
+                            "--columns FILE: Columns - Evaluate each "
+                            "expression of the script once for every row of "
+                            "a file of columns\n"
+                            "--profile[=FILE]: Profile - Report the lines "
+                            "that took longest, and write the time spent in "
+                            "each stack of frames to FILE\n"
+                            "-j N: Jobs - Run the given scripts on up to N "
+                            "threads\n"
+                            "--serve SOCKET: Serve - Accept sessions on a "
+                            "Unix domain socket, after running the script, "
+                            "if any\n"
+                            "--emit-c: Emit C - Print a C program that "
+                            "produces the script's output, instead of "
+                            "running it";
 const char *INTERACTIVE_PROMPT = ">>> ";
 const char *NONINTERACTIVE_PROMPT = "";
 
-const char *PROMPT;
-
 int main(int argc, char **argv)
 {
     FILE *fp = stdin;
-    PROMPT = INTERACTIVE_PROMPT;
+    VERBOSITY verbosity = NORMAL;
+    ECHO echo = YES;
+    DIGITS digits = ROUNDED;
+    OUTPUT output = TEXT;
+    unsigned jobs = 1;
+    const char *serve = NULL;
+    const char *columns = NULL;
+    bool profile = false;
+    const char *stacks = NULL;
+    bool emit = false;
 
     int i = 1;
     if (argc > 1) {
@@ -39,6 +65,46 @@ int main(int argc, char **argv)
             if (strcmp(argv[i], "-q") == 0) verbosity = QUIET;
             else if (strcmp(argv[i], "-v") == 0) verbosity = VERBOSE;
             else if (strcmp(argv[i], "--no-echo") == 0) echo = NO;
+            else if (strcmp(argv[i], "--shortest") == 0) digits = SHORTEST;
+            else if (strcmp(argv[i], "--output=text") == 0) output = TEXT;
+            else if (strcmp(argv[i], "--output=binary") == 0) output = BINARY;
+            else if (strncmp(argv[i], "--output=", 9) == 0) {
+                fprintf(stderr, "%s: --output expects text or binary\n",
+                                argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            else if (strcmp(argv[i], "-j") == 0) {
+                char *end = NULL;
+                long n = (i + 1 < argc) ? strtol(argv[++i], &end, 10) : 0;
+                if ((end == NULL) || (*end != '\0') || (n <= 0)) {
+                    fprintf(stderr, "%s: -j expects a positive number of "
+                                    "jobs\n", argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                jobs = n;
+            }
+            else if (strcmp(argv[i], "--serve") == 0) {
+                if (++i == argc) {
+                    fprintf(stderr, "%s: --serve expects a socket path\n",
+                                    argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                serve = argv[i];
+            }
+            else if (strcmp(argv[i], "--columns") == 0) {
+                if (++i == argc) {
+                    fprintf(stderr, "%s: --columns expects a file of "
+                                    "columns\n", argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                columns = argv[i];
+            }
+            else if (strcmp(argv[i], "--profile") == 0) profile = true;
+            else if (strncmp(argv[i], "--profile=", 10) == 0) {
+                profile = true;
+                stacks = argv[i] + 10;
+            }
+            else if (strcmp(argv[i], "--emit-c") == 0) emit = true;
             else if (strcmp(argv[i], "-h") == 0) {
                 fprintf(stdout, "%s\n", HELPME);
                 exit(EXIT_SUCCESS);
@@ -47,110 +113,97 @@ int main(int argc, char **argv)
         }
     }
 
-    if (argv[i] != '\0') {
+    if ((output == BINARY) && ((serve != NULL) || emit)) {
+        fprintf(stderr, "%s: --output=binary only applies to running "
+                        "scripts\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if ((columns != NULL) && ((serve != NULL) || emit || (argc - i > 1))) {
+        fprintf(stderr, "%s: --columns applies to running one script\n",
+                        argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (profile && ((serve != NULL) || emit || (argc - i > 1))) {
+        fprintf(stderr, "%s: --profile applies to running one script\n",
+                        argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Several scripts are each run in their own environment
+    if ((argc - i > 1) && (serve == NULL) && !emit) {
+        int failures = Script_run_all(argv + i, argc - i, jobs, verbosity,
+                                      echo, digits, output);
+        return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    CalcContext ctx = Context_new(add_basis(Env_new()), stdout, stderr);
+    ctx->prompt = INTERACTIVE_PROMPT;
+    ctx->verbosity = verbosity;
+    ctx->echo = echo;
+    ctx->digits = digits;
+    ctx->output = output;
+
+    if (argc - i > 1) {
+        fprintf(stderr, "Ignoring scripts after the first when %s: "
+                        " The first is: [%s]\n",
+                        emit ? "emitting C" : "serving", argv[i + 1]);
+    }
+
+    if (i < argc) {
         fp = fopen(argv[i], "r");
-        FILENAME = argv[i];
-        PROMPT = NONINTERACTIVE_PROMPT;
+        ctx->filename = argv[i];
+        ctx->prompt = NONINTERACTIVE_PROMPT;
         if (fp == NULL) {
             perror(argv[0]);
             exit(EXIT_FAILURE);
         }
     }
 
-    if (++i < argc) {
-        fprintf(stderr, "Ignoring options specified after filename: "
-                        " The first is: [%s]\n", argv[i]);
+    Columns rows = NULL;
+    if (columns != NULL) {
+        rows = Columns_open(columns, stderr);
+        if (rows == NULL) exit(EXIT_FAILURE);
     }
 
 /****************************************************************************/
 
-    Env e = Env_new();
-    e = add_basis(e);
-
-    char *line = NULL;
-    size_t size = 0;
-    size_t len = 0;
+    // Lines are timed one after another, on this thread alone
+    Profile lines = NULL;
+    if (profile) {
+        lines = Profile_new();
+        ctx->profile = lines;
+        ctx->threads = 1;
+    }
 
-    if (verbosity != QUIET) fprintf(stdout, "%s", PROMPT);
-    fflush(stdout);
+    int status = EXIT_SUCCESS;
 
-    while ((len = my_getline(&line, &size, fp)) != (size_t) -1) {
-        ++LINE_NUMBER;
-        line[--len] = '\0';
-        if (len == 0) {
-            if (verbosity != QUIET) fprintf(stdout, "%s", PROMPT);
-            fflush(stdout);
-            continue;
-        }
-
-        SubExp s = parse(line, e);
-        AST_Node root = SubExp_toAST(s);
-        AST_replace_vars(root, e);
-    
-        if ((verbosity != QUIET) && (root != NULL) && !AST_validate(root)) {
-            if (verbosity == VERBOSE)
-                fprintf(stderr, "%s [Line %d]: "
-                                "Incomplete expression!\n",
-                                FILENAME, LINE_NUMBER);
-        }
-    
-        Type t = AST_typeof(root, e, (verbosity == QUIET) ? false : true);
-        if ((t != NONE) && (t != INVALID)) {
-            if ((echo == YES) &&(verbosity == NORMAL)) {
-                if ((root->v.type == OP) || (root->v.type == RELAT_OP))
-                    AST_print(root);
-            } else if ((echo == YES) &&(verbosity == VERBOSE)) {
-                if ((root->v.type == OP) || (root->v.type == RELAT_OP))
-                    AST_print_verbose(root);
-            }
+    // A server's sessions all start from what its script bound
+    if (emit) Emit_c(ctx, fp, stdout);
+    else if (rows != NULL) Script_run_rows(ctx, fp, rows);
+    else if ((fp != stdin) && !profile) Script_run_pipelined(ctx, fp);
+    else if (serve == NULL) Script_run(ctx, fp);
+    if ((serve != NULL) && !emit) {
+        status = Server_run(serve, ctx->env, verbosity, echo, digits);
+    }
 
-            Value result = AST_eval(root);
-            switch (result.type) {
-                case NUMBER:
-                    fprintf(stdout, "= %.15g\n", result.u.d);
-                    break;
-                case STRING:
-                    fputc('\"', stdout);
-                    print_string(result.u.s, stdout);
-                    fputc('\"', stdout);
-                    fputc('\n', stdout);
-                    break;
-                case BOOL:
-                    fprintf(stdout, "= %s\n", result.u.b ?
-                                              "<True>" : "<False>");
-                    break;
-                case NONE:
-                case INVALID:
-                case VAR:
-                case OP:
-                case RELAT_OP:
-                    fprintf(stderr, "%s [Line %d]: %s\n", FILENAME, LINE_NUMBER,
-                                    "Argh! You've found an interpreter "
-                                    "bug: Impossible value");
-                    break;
-            }
-            Value_free(&result);
-        } else if (t == INVALID) {
-            if (verbosity != QUIET)
-                fprintf(stderr, "%s [Line %d]: Invalid expression\n",
-                                FILENAME, LINE_NUMBER);
-        } else {
-            if (verbosity != QUIET)
-                fprintf(stderr, "%s [Line %d]: Expression is not well-typed/"
-                                "well-formed\n", FILENAME, LINE_NUMBER);
+    if (profile) {
+        Profile_report(lines, stderr);
+        FILE *out = (stacks != NULL) ? fopen(stacks, "w") : NULL;
+        if (out != NULL) {
+            Profile_stacks(lines, out);
+            fclose(out);
+        } else if (stacks != NULL) {
+            perror(stacks);
+            status = EXIT_FAILURE;
         }
-    
-        AST_free(&root);
-        SubExp_free(&s);
-
-        if (verbosity != QUIET) fprintf(stdout, "%s", PROMPT);
-        fflush(stdout);
+        Profile_free(&lines);
     }
-    Env_free(&e);
-    free(line);
 
     if (fp != stdin) fclose(fp);
-    fputc('\n', stdout);
+    Columns_free(&rows);
+    Context_free(&ctx);
 
-    return 0;
+    return status;
 }
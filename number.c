@@ -0,0 +1,513 @@
+#include "number.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <ctype.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/****************************************************************************/
+
+/* A decimal as written, w * 10^q */
+typedef struct Decimal {
+    /* The first significant digits, as many as always fit */
+    uint64_t w;
+    int64_t q;
+    /* Whether nonzero digits past those were dropped */
+    bool truncated;
+    /* Whether it has neither a point nor an exponent */
+    bool whole;
+} Decimal;
+
+#define MAX_DIGITS 19
+/* Larger exponents are left to strtod, which saturates them */
+#define MAX_EXPONENT 100000
+
+static bool scan(const char *s, Decimal *d);
+static bool other(const char *token, Value *v);
+static bool convert(Decimal d, double *x);
+static bool exact(Decimal d, double *x);
+static bool lemire(Decimal d, double *x);
+static bool rounded(double x, unsigned p, uint64_t *d, int *e);
+static size_t layout(uint64_t d, int e, unsigned p, bool negative,
+                     char *buf);
+static size_t printed(double x, bool shortest, char *buf);
+
+static const uint64_t WHOLE_POWERS_OF_TEN[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000),
+    UINT64_C(10000), UINT64_C(100000), UINT64_C(1000000),
+    UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+    UINT64_C(10000000000), UINT64_C(100000000000),
+    UINT64_C(1000000000000), UINT64_C(10000000000000),
+    UINT64_C(100000000000000), UINT64_C(1000000000000000),
+    UINT64_C(10000000000000000), UINT64_C(100000000000000000)
+};
+
+#define MIN_DIGITS 15
+#define MAX_SHORTEST 17
+
+static const double POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* The leading 128 bits of each power of five, truncated for the positive */
+/* ones and rounded up for the negative ones                              */
+#define MIN_POWER (-64)
+#define MAX_POWER 64
+static const uint64_t POWERS_OF_FIVE[][2] = {
+    {0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL}, /* 5^-64 */
+    {0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL}, /* 5^-63 */
+    {0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL}, /* 5^-62 */
+    {0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL}, /* 5^-61 */
+    {0xCDB02555653131B6ULL, 0x3792F412CB06794DULL}, /* 5^-60 */
+    {0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL}, /* 5^-59 */
+    {0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL}, /* 5^-58 */
+    {0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL}, /* 5^-57 */
+    {0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL}, /* 5^-56 */
+    {0x9CED737BB6C4183DULL, 0x55464DD69685606BULL}, /* 5^-55 */
+    {0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL}, /* 5^-54 */
+    {0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL}, /* 5^-53 */
+    {0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL}, /* 5^-52 */
+    {0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL}, /* 5^-51 */
+    {0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL}, /* 5^-50 */
+    {0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL}, /* 5^-49 */
+    {0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL}, /* 5^-48 */
+    {0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL}, /* 5^-47 */
+    {0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL}, /* 5^-46 */
+    {0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL}, /* 5^-45 */
+    {0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL}, /* 5^-44 */
+    {0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL}, /* 5^-43 */
+    {0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL}, /* 5^-42 */
+    {0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL}, /* 5^-41 */
+    {0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL}, /* 5^-40 */
+    {0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL}, /* 5^-39 */
+    {0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL}, /* 5^-38 */
+    {0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL}, /* 5^-37 */
+    {0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL}, /* 5^-36 */
+    {0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL}, /* 5^-35 */
+    {0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL}, /* 5^-34 */
+    {0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL}, /* 5^-33 */
+    {0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL}, /* 5^-32 */
+    {0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL}, /* 5^-31 */
+    {0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL}, /* 5^-30 */
+    {0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL}, /* 5^-29 */
+    {0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL}, /* 5^-28 */
+    {0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL}, /* 5^-27 */
+    {0xC612062576589DDAULL, 0x95364AFE032A819EULL}, /* 5^-26 */
+    {0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL}, /* 5^-25 */
+    {0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL}, /* 5^-24 */
+    {0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL}, /* 5^-23 */
+    {0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL}, /* 5^-22 */
+    {0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL}, /* 5^-21 */
+    {0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL}, /* 5^-20 */
+    {0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL}, /* 5^-19 */
+    {0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL}, /* 5^-18 */
+    {0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL}, /* 5^-17 */
+    {0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL}, /* 5^-16 */
+    {0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL}, /* 5^-15 */
+    {0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL}, /* 5^-14 */
+    {0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL}, /* 5^-13 */
+    {0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL}, /* 5^-12 */
+    {0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL}, /* 5^-11 */
+    {0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL}, /* 5^-10 */
+    {0x89705F4136B4A597ULL, 0x31680A88F8953031ULL}, /* 5^-9 */
+    {0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL}, /* 5^-8 */
+    {0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL}, /* 5^-7 */
+    {0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL}, /* 5^-6 */
+    {0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL}, /* 5^-5 */
+    {0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL}, /* 5^-4 */
+    {0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL}, /* 5^-3 */
+    {0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL}, /* 5^-2 */
+    {0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL}, /* 5^-1 */
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, /* 5^0 */
+    {0xA000000000000000ULL, 0x0000000000000000ULL}, /* 5^1 */
+    {0xC800000000000000ULL, 0x0000000000000000ULL}, /* 5^2 */
+    {0xFA00000000000000ULL, 0x0000000000000000ULL}, /* 5^3 */
+    {0x9C40000000000000ULL, 0x0000000000000000ULL}, /* 5^4 */
+    {0xC350000000000000ULL, 0x0000000000000000ULL}, /* 5^5 */
+    {0xF424000000000000ULL, 0x0000000000000000ULL}, /* 5^6 */
+    {0x9896800000000000ULL, 0x0000000000000000ULL}, /* 5^7 */
+    {0xBEBC200000000000ULL, 0x0000000000000000ULL}, /* 5^8 */
+    {0xEE6B280000000000ULL, 0x0000000000000000ULL}, /* 5^9 */
+    {0x9502F90000000000ULL, 0x0000000000000000ULL}, /* 5^10 */
+    {0xBA43B74000000000ULL, 0x0000000000000000ULL}, /* 5^11 */
+    {0xE8D4A51000000000ULL, 0x0000000000000000ULL}, /* 5^12 */
+    {0x9184E72A00000000ULL, 0x0000000000000000ULL}, /* 5^13 */
+    {0xB5E620F480000000ULL, 0x0000000000000000ULL}, /* 5^14 */
+    {0xE35FA931A0000000ULL, 0x0000000000000000ULL}, /* 5^15 */
+    {0x8E1BC9BF04000000ULL, 0x0000000000000000ULL}, /* 5^16 */
+    {0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL}, /* 5^17 */
+    {0xDE0B6B3A76400000ULL, 0x0000000000000000ULL}, /* 5^18 */
+    {0x8AC7230489E80000ULL, 0x0000000000000000ULL}, /* 5^19 */
+    {0xAD78EBC5AC620000ULL, 0x0000000000000000ULL}, /* 5^20 */
+    {0xD8D726B7177A8000ULL, 0x0000000000000000ULL}, /* 5^21 */
+    {0x878678326EAC9000ULL, 0x0000000000000000ULL}, /* 5^22 */
+    {0xA968163F0A57B400ULL, 0x0000000000000000ULL}, /* 5^23 */
+    {0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL}, /* 5^24 */
+    {0x84595161401484A0ULL, 0x0000000000000000ULL}, /* 5^25 */
+    {0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL}, /* 5^26 */
+    {0xCECB8F27F4200F3AULL, 0x0000000000000000ULL}, /* 5^27 */
+    {0x813F3978F8940984ULL, 0x4000000000000000ULL}, /* 5^28 */
+    {0xA18F07D736B90BE5ULL, 0x5000000000000000ULL}, /* 5^29 */
+    {0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL}, /* 5^30 */
+    {0xFC6F7C4045812296ULL, 0x4D00000000000000ULL}, /* 5^31 */
+    {0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL}, /* 5^32 */
+    {0xC5371912364CE305ULL, 0x6C28000000000000ULL}, /* 5^33 */
+    {0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL}, /* 5^34 */
+    {0x9A130B963A6C115CULL, 0x3C7F400000000000ULL}, /* 5^35 */
+    {0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL}, /* 5^36 */
+    {0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL}, /* 5^37 */
+    {0x96769950B50D88F4ULL, 0x1314448000000000ULL}, /* 5^38 */
+    {0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL}, /* 5^39 */
+    {0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL}, /* 5^40 */
+    {0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL}, /* 5^41 */
+    {0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL}, /* 5^42 */
+    {0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL}, /* 5^43 */
+    {0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL}, /* 5^44 */
+    {0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL}, /* 5^45 */
+    {0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL}, /* 5^46 */
+    {0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL}, /* 5^47 */
+    {0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL}, /* 5^48 */
+    {0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL}, /* 5^49 */
+    {0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL}, /* 5^50 */
+    {0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL}, /* 5^51 */
+    {0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL}, /* 5^52 */
+    {0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL}, /* 5^53 */
+    {0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL}, /* 5^54 */
+    {0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL}, /* 5^55 */
+    {0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL}, /* 5^56 */
+    {0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL}, /* 5^57 */
+    {0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL}, /* 5^58 */
+    {0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL}, /* 5^59 */
+    {0x9F4F2726179A2245ULL, 0x01D762422C946590ULL}, /* 5^60 */
+    {0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL}, /* 5^61 */
+    {0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL}, /* 5^62 */
+    {0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL}, /* 5^63 */
+    {0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL}, /* 5^64 */
+};
+
+/****************************************************************************/
+
+bool Number_parse(const char *token, Value *v)
+{
+    Decimal d;
+    if (!scan(token, &d)) return other(token, v);
+    if (v == NULL) return true;
+
+    if (d.whole && (d.q == 0) && (d.w <= INT64_MAX)) {
+        *v = Value_new_integer((int64_t) d.w);
+        return true;
+    }
+    double x;
+    if (!convert(d, &x)) x = strtod(token, NULL);
+    *v = Value_new_number(x);
+    return true;
+}
+
+size_t Number_format(double x, bool shortest, char *buf)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bool negative = (bits >> 63) != 0;
+    if ((bits << 1) == 0) return layout(0, 0, 1, negative, buf);
+
+    for (unsigned p = MIN_DIGITS; p <= MAX_SHORTEST; ++p) {
+        uint64_t d;
+        int e;
+        if (!rounded(x, p, &d, &e)) return printed(x, shortest, buf);
+        if (!shortest || (p == MAX_SHORTEST)) {
+            return layout(d, e, p, negative, buf);
+        }
+
+        Decimal back = {d, (int64_t) e - (int64_t) (p - 1), false, false};
+        double y;
+        if (!convert(back, &y)) return printed(x, shortest, buf);
+        if (y == fabs(x)) return layout(d, e, p, negative, buf);
+    }
+    return 0;
+}
+
+/****************************************************************************/
+
+/* Whether all of s is a decimal, digits with at most one point and then */
+/* perhaps an exponent, and if so what it is                            */
+bool scan(const char *s, Decimal *d)
+{
+    d->w = 0;
+    d->q = 0;
+    d->truncated = false;
+    d->whole = true;
+
+    unsigned kept = 0;
+    bool any = false;
+    bool point = false;
+    for (;; ++s) {
+        if (*s == '.') {
+            if (point) return false;
+            point = true;
+            d->whole = false;
+            continue;
+        }
+        if ((*s < '0') || (*s > '9')) break;
+        any = true;
+        if ((d->w == 0) && (*s == '0')) {
+            // Leading zeros only shift the point
+            if (point) --d->q;
+        } else if (kept < MAX_DIGITS) {
+            d->w = (d->w * 10) + (uint64_t) (*s - '0');
+            ++kept;
+            if (point) --d->q;
+        } else {
+            if (*s != '0') d->truncated = true;
+            if (!point) ++d->q;
+        }
+    }
+    if (!any) return false;
+
+    if ((*s == 'e') || (*s == 'E')) {
+        d->whole = false;
+        ++s;
+        bool negative = (*s == '-');
+        if ((*s == '+') || (*s == '-')) ++s;
+        if ((*s < '0') || (*s > '9')) return false;
+        int64_t e = 0;
+        for (; (*s >= '0') && (*s <= '9'); ++s) {
+            if (e < MAX_EXPONENT) e = (e * 10) + (*s - '0');
+        }
+        d->q += negative ? -e : e;
+    }
+    return *s == '\0';
+}
+
+/* The other forms strtod takes: hexadecimal, infinity and NaN, any of */
+/* them signed. Names are turned away without calling it               */
+bool other(const char *token, Value *v)
+{
+    bool sign = (*token == '+') || (*token == '-');
+    const char *s = token + sign;
+    bool hex = (s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'));
+    int c = tolower((unsigned char) *s);
+    if (!sign && !hex && (c != 'i') && (c != 'n')) return false;
+
+    char *end = NULL;
+    double x = strtod(token, &end);
+    if ((end == token) || (*end != '\0')) return false;
+    if (v != NULL) *v = Value_new_number(x);
+    return true;
+}
+
+/* The double nearest d, unless it takes strtod to tell. Dropped digits */
+/* put d between w and w + 1, which may still round alike              */
+bool convert(Decimal d, double *x)
+{
+    if (d.w == 0) {
+        *x = 0;
+        return true;
+    }
+    if (d.truncated) {
+        Decimal above = d;
+        ++above.w;
+        double y;
+        return lemire(d, x) && lemire(above, &y) && (*x == y);
+    }
+    return exact(d, x) || lemire(d, x);
+}
+
+/* When w and 10^|q| are both doubles exactly, one operation rounds once */
+bool exact(Decimal d, double *x)
+{
+    if ((FLT_EVAL_METHOD != 0) || (d.w > (UINT64_C(1) << 53)) ||
+            (d.q < -22) || (d.q > 22)) {
+        return false;
+    }
+    *x = (double) d.w;
+    *x = (d.q < 0) ? *x / POWERS_OF_TEN[-d.q] : *x * POWERS_OF_TEN[d.q];
+    return true;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+__extension__ typedef unsigned __int128 uint128;
+
+/* w * 5^q, normalized, has its top 55 bits right unless the rest of the */
+/* product is all ones; those are the 53 of the double, one to say where */
+/* the leading bit is and one to round by                                */
+bool lemire(Decimal d, double *x)
+{
+    if ((d.q < MIN_POWER) || (d.q > MAX_POWER)) return false;
+
+    int lz = __builtin_clzll(d.w);
+    uint64_t w = d.w << lz;
+    const uint64_t *p = POWERS_OF_FIVE[d.q - MIN_POWER];
+    uint128 product = (uint128) w * p[0];
+    uint64_t hi = (uint64_t) (product >> 64);
+    uint64_t lo = (uint64_t) product;
+    if ((hi & 0x1FF) == 0x1FF) {
+        // Only the second word can settle the bits below those kept
+        uint64_t carry = (uint64_t) (((uint128) w * p[1]) >> 64);
+        lo += carry;
+        if (carry > lo) ++hi;
+    }
+    if ((lo == UINT64_MAX) && ((d.q < -27) || (d.q > 55))) return false;
+
+    unsigned upper = (unsigned) (hi >> 63);
+    unsigned shift = upper + 9;
+    uint64_t m = hi >> shift;
+    // 217706 / 2^16 is just above log2(10), so this is floor(q log2(10))
+    int64_t e = ((217706 * d.q) >> 16) + 63 + upper - lz + 1023;
+    if ((e <= 0) || (e >= 0x7FF)) return false;
+
+    // Exactly halfway between two doubles: round to the even one
+    if ((lo <= 1) && (d.q >= -4) && (d.q <= 23) && ((m & 3) == 1) &&
+            ((m << shift) == hi)) {
+        m &= ~UINT64_C(1);
+    }
+    m = (m + (m & 1)) >> 1;
+    if (m >= (UINT64_C(2) << 52)) {
+        m = UINT64_C(1) << 52;
+        ++e;
+    }
+    m &= ~(UINT64_C(1) << 52);
+
+    uint64_t bits = m | ((uint64_t) e << 52);
+    memcpy(x, &bits, sizeof(*x));
+    return true;
+}
+
+/* |x| to p significant digits, correctly rounded, as d * 10^(e - p + 1) */
+/* with d of exactly p digits. The product by the power of ten is wide    */
+/* enough to be off only far below the digit rounded at; a fraction that */
+/* near one half is left undecided, as are subnormals                     */
+bool rounded(double x, unsigned p, uint64_t *d, int *e)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int biased = (int) ((bits >> 52) & 0x7FF);
+    if ((biased == 0) || (biased == 0x7FF)) return false;
+    uint64_t m = (bits & ((UINT64_C(1) << 52) - 1)) | (UINT64_C(1) << 52);
+    int64_t e2 = biased - 1075;
+
+    // 78913 / 2^18 is just below log10(2), so this is at most one off
+    int64_t guess = ((e2 + 52) * 78913) >> 18;
+    for (unsigned tries = 0; tries < 3; ++tries) {
+        int64_t k = (int64_t) p - 1 - guess;
+        if ((k < MIN_POWER) || (k > MAX_POWER)) return false;
+
+        // x * 10^k = (m << 11) * 5^k * 2^(e2 - 11 + k), with 5^k from the
+        // table as its leading 128 bits times 2^(floor(k log2(5)) - 127)
+        const uint64_t *f = POWERS_OF_FIVE[k - MIN_POWER];
+        uint64_t w = m << 11;
+        uint128 hi = (uint128) w * f[0];
+        uint128 lo = (uint128) w * f[1];
+        uint128 top = hi + (lo >> 64);
+        uint64_t bottom = (uint64_t) lo;
+        int64_t shift = 11 - e2 - k - (((152170 * k) >> 16) - 127);
+        if ((shift <= 128) || (shift >= 192)) return false;
+
+        uint64_t whole = (uint64_t) (top >> (shift - 64));
+        uint128 fraction = (top << (192 - shift)) |
+                           (uint128) (bottom >> (shift - 128));
+        if (whole >= WHOLE_POWERS_OF_TEN[p]) {
+            ++guess;
+            continue;
+        }
+        if (whole < WHOLE_POWERS_OF_TEN[p - 1]) {
+            --guess;
+            continue;
+        }
+
+        uint128 half = (uint128) 1 << 127;
+        uint128 slack = (uint128) 1 << 72;
+        if ((fraction > half - slack) && (fraction < half + slack)) {
+            return false;
+        }
+        if (fraction > half) ++whole;
+        if (whole == WHOLE_POWERS_OF_TEN[p]) {
+            whole = WHOLE_POWERS_OF_TEN[p - 1];
+            ++guess;
+        }
+        *d = whole;
+        *e = (int) guess;
+        return true;
+    }
+    return false;
+}
+
+#else
+
+bool lemire(Decimal d, double *x)
+{
+    (void) d;
+    (void) x;
+    return false;
+}
+
+bool rounded(double x, unsigned p, uint64_t *d, int *e)
+{
+    (void) x;
+    (void) p;
+    (void) d;
+    (void) e;
+    return false;
+}
+
+#endif
+
+/* p digits d, the first of them at 10^e, as %g lays them out: with an */
+/* exponent if that is below -4 or at least p, with no trailing zeros  */
+size_t layout(uint64_t d, int e, unsigned p, bool negative, char *buf)
+{
+    char digits[MAX_SHORTEST + 1];
+    for (unsigned i = p; i-- > 0; d /= 10) digits[i] = (char) ('0' + d % 10);
+    unsigned n = p;
+    while ((n > 1) && (digits[n - 1] == '0')) --n;
+
+    char *s = buf;
+    if (negative) *s++ = '-';
+    if ((e < -4) || (e >= (int) p)) {
+        *s++ = digits[0];
+        if (n > 1) {
+            *s++ = '.';
+            memcpy(s, digits + 1, n - 1);
+            s += n - 1;
+        }
+        *s++ = 'e';
+        *s++ = (e < 0) ? '-' : '+';
+        unsigned a = (unsigned) ((e < 0) ? -e : e);
+        if (a >= 100) *s++ = (char) ('0' + a / 100);
+        *s++ = (char) ('0' + (a / 10) % 10);
+        *s++ = (char) ('0' + a % 10);
+    } else if (e >= 0) {
+        for (unsigned i = 0; i <= (unsigned) e; ++i) {
+            *s++ = (i < n) ? digits[i] : '0';
+        }
+        if (n > (unsigned) e + 1) {
+            *s++ = '.';
+            memcpy(s, digits + e + 1, n - e - 1);
+            s += n - e - 1;
+        }
+    } else {
+        *s++ = '0';
+        *s++ = '.';
+        for (int i = -1; i > e; --i) *s++ = '0';
+        memcpy(s, digits, n);
+        s += n;
+    }
+    *s = '\0';
+    return (size_t) (s - buf);
+}
+
+/* By way of printf, for what the table leaves undecided */
+size_t printed(double x, bool shortest, char *buf)
+{
+    for (int p = MIN_DIGITS; ; ++p) {
+        int n = snprintf(buf, NUMBER_SIZE, "%.*g", p, x);
+        if (!shortest || (p == MAX_SHORTEST) || (strtod(buf, NULL) == x)) {
+            return (size_t) n;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef CALC_NUMBER_H
+#define CALC_NUMBER_H
+
+#include "value.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Numbers read from and written as decimal text.                    *
+ *                                                                   *
+ * Literals are recognized and converted in one pass over the token, *
+ * rounded correctly without strtod: exactly with doubles when the   *
+ * digits and the power of ten both fit one, and otherwise with a    *
+ * 128-bit product by a table of powers of five (Eisel and Lemire's  *
+ * method). The few cases that leaves undecided, and the             *
+ * hexadecimal, infinite and NaN forms strtod also accepts, are left *
+ * to strtod.                                                        *
+ *                                                                   *
+ * Results are written with the same table run the other way, giving *
+ * exactly what printf would, and printf is only called on for the   *
+ * digits that product cannot decide.                                *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Room for any number Number_format writes, and its terminator */
+#define NUMBER_SIZE 32
+
+/* Whether all of token is a number. If so and v is not NULL, *v is its  */
+/* value: exact while it is whole and fits an integer, and otherwise the */
+/* nearest double                                                        */
+bool Number_parse(const char *token, Value *v);
+
+/* Write x into buf as %.15g does. If shortest, with as many more digits */
+/* as it takes, up to 17, for the text to read back as x: the first of   */
+/* %.15g, %.16g and %.17g that does. Returns the length written          */
+size_t Number_format(double x, bool shortest, char *buf);
+
+#endif
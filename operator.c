@@ -21,12 +21,20 @@ static const char *PROD_STR =      "[PRODUCT]";
 static const char *QUOT_STR =      "[QUOTIENT]";
 static const char *SUM_STR =       "[SUM]";
 static const char *DIFF_STR =      "[DIFFERENCE]";
+static const char *CONJ_STR =      "[CONJUNCTION]";
+static const char *DISJ_STR =      "[DISJUNCTION]";
+static const char *COND_STR =      "[CONDITIONAL]";
+static const char *BRANCHES_STR =  "[BRANCHES]";
+static const char *CALL_STR =      "[CALL]";
+static const char *ARG_STR =       "[ARGUMENT]";
+static const char *RANGE_STR =     "[RANGE]";
 
 /****************************************************************************/
 
 bool isOperator(char *str)
 {
     if (str == NULL) return false;
+    if (!strcmp(str, CONJ_SYMBOL) || !strcmp(str, DISJ_SYMBOL)) return true;
     if (str[1] != '\0') return false;
 
     switch (*str) {
@@ -57,6 +65,13 @@ const char *OPERATORtostring(OPERATOR op)
         case QUOT:      return QUOT_STR;
         case SUM:       return SUM_STR;
         case DIFF:      return DIFF_STR;
+        case CONJ:      return CONJ_STR;
+        case DISJ:      return DISJ_STR;
+        case COND:      return COND_STR;
+        case BRANCHES:  return BRANCHES_STR;
+        case CALL:      return CALL_STR;
+        case ARG:       return ARG_STR;
+        case RANGE:     return RANGE_STR;
         default:        return NULL;
     }
 }
@@ -74,6 +89,13 @@ OPERATOR stringtoOPERATOR(char *str)
     else if (!strcmp(str, QUOT_STR))     return QUOT;
     else if (!strcmp(str, SUM_STR))      return SUM;
     else if (!strcmp(str, DIFF_STR))     return DIFF;
+    else if (!strcmp(str, CONJ_STR))     return CONJ;
+    else if (!strcmp(str, DISJ_STR))     return DISJ;
+    else if (!strcmp(str, COND_STR))     return COND;
+    else if (!strcmp(str, BRANCHES_STR)) return BRANCHES;
+    else if (!strcmp(str, CALL_STR))     return CALL;
+    else if (!strcmp(str, ARG_STR))      return ARG;
+    else if (!strcmp(str, RANGE_STR))    return RANGE;
     else {
         fprintf(stderr, "%s [%s] %s\n", "stringtoOPERATOR: cannot convert "
                                         "invalid string", str, "to OPERATOR");
@@ -122,6 +144,33 @@ char OPERATORtochar(OPERATOR op)
     }
 }
 
+OPERATOR symboltoOPERATOR(char *str)
+{
+    if (!strcmp(str, CONJ_SYMBOL))      return CONJ;
+    else if (!strcmp(str, DISJ_SYMBOL)) return DISJ;
+    else return chartoOPERATOR(*str);
+}
+
+const char *OPERATORtosymbol(OPERATOR op)
+{
+    static const char *SYMBOLS[] = {
+        "$", "&", "^", "|", "%", "\\", "*", "/", "+", "-",
+        CONJ_SYMBOL, DISJ_SYMBOL, "if", "else", "()", ",", "()"
+    };
+
+    if ((op < LITERAL) || (op > RANGE)) {
+        fprintf(stderr, "%s\n", "OPERATORtosymbol: cannot convert invalid "
+                                "OPERATOR to symbol");
+        exit(EXIT_FAILURE);
+    }
+    return SYMBOLS[op];
+}
+
+bool isLogical(OPERATOR op)
+{
+    return (op == CONJ) || (op == DISJ);
+}
+
 bool hasHigherPriorityThan(OPERATOR lhs, OPERATOR rhs)
 {
     if (lhs == rhs) return false;
@@ -137,6 +186,8 @@ bool hasHigherPriorityThan(OPERATOR lhs, OPERATOR rhs)
         case QUOT:      return (lhs < rhs);
         case SUM:       return (lhs < rhs) && !(rhs == DIFF);
         case DIFF:      return (lhs < rhs);
+        case CONJ:      return (lhs < rhs);
+        case DISJ:      return (lhs < rhs);
         default:        return false;
     }
 }
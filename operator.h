@@ -12,9 +12,12 @@ typedef enum OPERATOR { LITERAL = 0,
                     EXP, LOG,
                     MOD, INT,
                     PROD, QUOT,
-                    SUM, DIFF
+                    SUM, DIFF,
+                    CONJ, DISJ,
+                    COND, BRANCHES,
+                    CALL, ARG, RANGE
                   } OPERATOR;
-static const char operators[] = "()^|%\\*/+-";
+static const char operators[] = "()^|%\\*/+-&";
 
 /****************************************************************************/
 
@@ -31,6 +34,11 @@ static const char operators[] = "()^|%\\*/+-";
 
 #define LPAREN '('
 #define RPAREN ')'
+#define COMMA  ','
+
+/* The logical operators are the only ones spelled with two characters */
+#define CONJ_SYMBOL "&&"
+#define DISJ_SYMBOL "||"
 
 /****************************************************************************/
 
@@ -42,6 +50,28 @@ const char *OPERATORtostring(OPERATOR op);
 OPERATOR chartoOPERATOR(char c);
 char OPERATORtochar(OPERATOR op);
 
+/* How the operator is written, for any operator but LITERAL */
+OPERATOR symboltoOPERATOR(char *str);
+const char *OPERATORtosymbol(OPERATOR op);
+
+/* A conditional is a COND node with the condition on its left and a   */
+/* BRANCHES node on its right, holding the then branch on its left and */
+/* the else branch on its right. Like a parenthesized group, it is a   */
+/* single operand to the operators around it                           */
+
+/* A call is a CALL node with the name called on its left and a chain  */
+/* of ARG nodes on its right, each holding an argument on its left and */
+/* the next ARG, if any, on its right. It too is a single operand      */
+
+/* A reduction over a range, such as sum(i, 1, n, i^2), is laid out as */
+/* a call, with a RANGE node holding the name of the reduction as a    */
+/* string. Its first argument is the index, as a local of a frame of   */
+/* its own that the last argument is evaluated in for each value       */
+
+/* && and || take booleans, and skip their right operand once the left */
+/* one decides the result                                              */
+bool isLogical(OPERATOR op);
+
 /* Exponentiation is right-associative */
 /* Everything else if left-associative */
 bool hasHigherPriorityThan(OPERATOR lhs, OPERATOR rhs);
@@ -1,8 +1,17 @@
 #include "parse.h"
-#include "env.h"
+#include "context.h"
 #include "value.h"
 #include "operator.h"
 #include "tokenize.h"
+#include "scope.h"
+#include "subexp.h"
+#include "reduce.h"
+#include "dag.h"
+#include "function.h"
+#include "range.h"
+#include "builtin.h"
+#include "number.h"
+#include "utility.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,168 +20,272 @@
 
 /****************************************************************************/
 
-Value let_binding(char **line, Env e);
-Env where_binding(char **line, char *token, Env e);
-
-SubExp expression(char **line, char *token);
+bool  let_header(char **line, Statement st, Scope *params, bool *memo,
+                 CalcContext ctx);
+Scope parameters(char **line, CalcContext ctx);
+Statement define(Statement st, Scope params, bool memo);
+Scope where_binding(char **line, char *token, CalcContext ctx);
+
+SubExp expression(char **line, char *token, CalcContext ctx);
+bool   conditional(SubExp *l, char *token, CalcContext ctx);
+SubExp close_branches(SubExp l);
+const char *expected(AST_Node open);
+Value  applied(char *token, char *rest, CalcContext ctx, OPERATOR *op);
+bool   function_name(char *token, CalcContext ctx);
+SubExp call(SubExp l, OPERATOR op, Value callee);
+bool   argument(SubExp *l, char *token, CalcContext ctx);
+bool   ranges(AST_Node root, CalcContext ctx);
+bool   conditionals(AST_Node root, CalcContext ctx);
+Type   evident_type(AST_Node root);
+bool   name(char *token);
 Value string(char **line, char *token);
 
 /****************************************************************************/
 
-SubExp parse(char *line, Env e)
+Statement parse(char *line, CalcContext ctx)
 {
     // fprintf(stdout, "parse: [%s]\n", line);
-    SubExp l = SubExp_new();
-    if (line == NULL) return l;
+    Statement st = Statement_new();
+    if (line == NULL) return st;
 
+    Scope params = NULL;
+    bool memo = false;
     char *token = next_token(&line);
 
     if ((isLeadingKeyword(token) != NULL)) {
         if (strcmp(token, LET) == 0) {
             free(token);
-            return SubExp_add(l, let_binding(&line, e));
+            if (!let_header(&line, st, &params, &memo, ctx)) return st;
+            token = next_token(&line);
         } else {
-            fprintf(stderr, "%s [Line %d]: Argh! You've found an interpreter "
-                            "bug! (parse)\n", FILENAME, LINE_NUMBER);
+            Context_error(ctx, "Argh! You've found an interpreter bug! "
+                               "(parse)\n");
         }
-    } else {
-        // General expression must follow
-        SubExp_free(&l);
-        l = expression(&line, token);
-        if ((token = next_token(&line)) != NULL) {
-            e = where_binding(&line, token,
-                Env_new_extension(e));
-            SubExp_replace_vars(l, e);
-            Env_free(&e);
-            free(token);
-        } else free(token);
     }
 
-    return l;
+    // General expression must follow
+    SubExp l = expression(&line, token, ctx);
+    st->root = SubExp_toAST(&l);
+    if (!ranges(st->root, ctx) || !conditionals(st->root, ctx)) {
+        AST_free(&st->root);
+    }
+
+    if ((token = next_token(&line)) != NULL) {
+        st->where = where_binding(&line, token, ctx);
+
+        // Where-bound names are visible to the expression and each other
+        Scope_resolve(st->where, 0, st->root);
+        for (unsigned i = 0; i < st->where->size; ++i) {
+            Scope_resolve(st->where, 0, st->where->exprs[i]);
+        }
+    }
+    if (params != NULL) return define(st, params, memo);
+
+    // A let naming a function makes another name for it, which can be
+    // called even where the parser has no environment to look it up in
+    if ((st->name != NULL) && (st->root != NULL) &&
+            (st->root->v.type == VAR) && (st->root->left == NULL) &&
+            (st->root->right == NULL) &&
+            function_name(st->root->v.u.name, ctx)) {
+        ctx->functions = Env_bind(ctx->functions, st->name,
+                                  Value_new_bool(true));
+    }
+
+    // Repeated subexpressions, anywhere in the statement, are shared
+    Dag d = Dag_new();
+    st->root = Dag_intern(d, st->root);
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        st->where->exprs[i] = Dag_intern(d, st->where->exprs[i]);
+    }
+    Dag_number(d, st->root);
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        Dag_number(d, st->where->exprs[i]);
+        Reduce_tree(st->where->exprs[i]);
+    }
+    Reduce_tree(st->root);
+    st->merged = Dag_merged(d);
+    Context_allocated(ctx, Dag_size(d));
+    Dag_free(&d);
+    Scope_order(st->where);
+
+    return st;
 }
 
 /****************************************************************************/
 
-Value let_binding(char **line, Env e)
+/* The name a let binds, and for a function its parameters and whether */
+/* it is memoized, up to the =. False if there is nothing to parse     */
+/* after it                                                            */
+bool let_header(char **line, Statement st, Scope *params, bool *memo,
+                CalcContext ctx)
 {
-    (void) line;
-    (void) e;
+    st->name = next_token(line);
+    char *token = next_token(line);
+
+    // memo is a modifier only where another name follows it
+    if ((st->name != NULL) && (strcmp(st->name, MEMO) == 0) &&
+            (token != NULL) && (*token != ASSIGN)) {
+        *memo = true;
+        free(st->name);
+        st->name = token;
+        token = next_token(line);
+    }
 
-    char *name = next_token(line);
-    char *assign = next_token(line);
+    if ((token != NULL) && (*token == LPAREN)) {
+        free(token);
+        if ((*params = parameters(line, ctx)) == NULL) return false;
+        token = next_token(line);
+    } else if (*memo) {
+        Context_error(ctx, "Parsing error: Expected parameters of [%s]\n",
+                           st->name);
+        free(token);
+        return false;
+    }
+    free(token);
 
-    bool has_additional_bindings = false;
+    // Known before the body is parsed, so that it may call itself
+    ctx->functions = Env_bind(ctx->functions, st->name,
+                              Value_new_bool(*params != NULL));
+    return true;
+}
 
-    SubExp s = parse(*line, e);
+/* Names, separated by commas, up to the closing parenthesis */
+Scope parameters(char **line, CalcContext ctx)
+{
+    Scope params = Scope_new();
 
     char *token;
-    char *tmp = *line;
-    if ((*line = find_next_word(*line, leads_with, WHERE)) != tmp) {
-        if ((token = next_token(line)) != NULL) {
-            e = where_binding(line, token, Env_new_extension(e));
+    while (((token = next_token(line)) != NULL) && name(token)) {
+        Scope_add(params, token, NULL);
+        free(token);
+
+        token = next_token(line);
+        if ((token != NULL) && (*token == RPAREN)) {
             free(token);
-            has_additional_bindings = true;
+            return params;
         }
+        if ((token == NULL) || (*token != COMMA)) break;
+        free(token);
     }
 
-    AST_Node root = SubExp_toAST(s);
-    AST_replace_vars(root, e);
-
-    if (has_additional_bindings) Env_free(&e);
+    if (token != NULL) {
+        Context_error(ctx, "Parsing error: Unexpected [%s] among "
+                           "parameters\n", token);
+    } else Context_error(ctx, "Parsing error: Expected parameters\n");
+    free(token);
+    Scope_free(&params);
+    return NULL;
+}
 
-    AST_validate(root);
+/* The expression and where clause of a function go into the function,  */
+/* which is all the statement then holds. Unlike a statement's, they are */
+/* not hash-consed: memos of shared subexpressions last a whole          */
+/* evaluation, and a body is evaluated once for every call               */
+Statement define(Statement st, Scope params, bool memo)
+{
+    if (st->root == NULL) {
+        Scope_free(&params);
+        return st;
+    }
 
-    (void) AST_typeof(root, e, true);
+    // Parameters live one frame outside the where clause's
+    unsigned depth = (st->where != NULL) ? 1 : 0;
+    Scope_resolve(params, depth, st->root);
+    Reduce_tree(st->root);
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        Scope_resolve(params, depth, st->where->exprs[i]);
+        Reduce_tree(st->where->exprs[i]);
+    }
+    Scope_order(st->where);
 
-    Value final = AST_eval(root);
-    AST_free(&root);
-    e = Env_bind(e, name, final);
-    SubExp_free(&s);
-    free(name);
-    free(assign);
+    Function fn = Function_new(st->name, params, st->root, st->where, memo);
+    st->root = AST_newv(Value_new_function(fn));
+    st->where = NULL;
 
-    return final;
+    return st;
 }
 
-Env where_binding(char **line, char *token, Env e)
+Scope where_binding(char **line, char *token, CalcContext ctx)
 {
-    char *name = next_token(line);
-    char *assign = next_token(line);
+    Scope sc = Scope_new();
 
-    if ((name == NULL) || (assign == NULL) ||
-            (isNonLeadingKeyword(token)) == NULL) {
-        fprintf(stderr, "%s [Line %d]: Syntax error: Expected additional "
-                        "bindings\n", FILENAME, LINE_NUMBER);
-        free(assign);
-        free(name);
-        return e;
-    }
+    while (isNonLeadingKeyword(token) != NULL) {
+        free(token);
 
-    token = next_token(line);
-    SubExp s = expression(line, token);
-    AST_Node root = SubExp_toAST(s);
-    Type isComplete = AST_typeof(root, e, false);
+        char *name = next_token(line);
+        char *assign = next_token(line);
+        token = next_token(line);
 
-    AST_replace_vars(root, e);
-    if (isComplete != NONE) {
-        Value v = AST_eval(root);
-        e = Env_bind(e, name, v);
-        Value_free(&v);
-    }
+        if ((name == NULL) || (assign == NULL) || (token == NULL)) {
+            Context_error(ctx, "Syntax error: Expected additional bindings\n");
+            free(name);
+            free(assign);
+            break;
+        }
 
-    token = next_token(line);
-    if (isNonLeadingKeyword(token)) {
-        e = where_binding(line, token, e);
-    }
+        SubExp s = expression(line, token, ctx);
+        AST_Node expr = SubExp_toAST(&s);
+        if (!ranges(expr, ctx) || !conditionals(expr, ctx)) AST_free(&expr);
+        Scope_add(sc, name, expr);
+        free(name);
+        free(assign);
 
-    if (root != NULL) {
-        AST_replace_vars(root, e);
-        if (isComplete == NONE) {
-            Value v = AST_eval(root);
-            e = Env_bind(e, name, v);
-            Value_free(&v);
-        }
-    } else {
-        fprintf(stderr, "%s [Line %d]: Syntax error: expected additional "
-                        "bindings\n", FILENAME, LINE_NUMBER);
+        token = next_token(line);
     }
-
-    free(name);
-    free(assign);
     free(token);
-    AST_free(&root);
-    SubExp_free(&s);
 
-    return e;
+    return sc;
 }
 
-SubExp expression(char **line, char *token)
+SubExp expression(char **line, char *token, CalcContext ctx)
 {
     // fprintf(stdout, "expression: [%s][%s]\n", token, *line);
     SubExp l = SubExp_new();
+    if (token == NULL) return l;
 
     char *last = NULL;
+    bool malformed = false;
+    Value num;
 
     do {
         // fprintf(stdout, "token: [%s]\n", token);
-        if (isNumber(token)) {
+        if (isConditionalKeyword(token)) {
+            if (!malformed && !conditional(&l, token, ctx)) malformed = true;
+        } else if (*token == COMMA) {
+            if (!malformed && !argument(&l, token, ctx)) malformed = true;
+        } else if (Number_parse(token, &num)) {
             if ((last != NULL) && (*last == RPAREN)) {
                 l = SubExp_add(l, Value_new_op(PROD)); 
             }
-            l = SubExp_add(l, Value_new_number(strtod(token, NULL)));
+            l = SubExp_add(l, num);
         } else if (isOperator(token)) {
             if ((*token == LPAREN)) {
                 if ((last != NULL) && ((*last == RPAREN) || isNumber(last) ||
                         (!isOperator(last) && !isNumber(last) &&
-                         !isKeyword(last) && !isRelOp(last)))) {
+                         !isKeyword(last) && !isRelOp(last) &&
+                         (*last != COMMA)))) {
                     l = SubExp_add(l, Value_new_op(PROD));
                 }
                 l = SubExp_add(l, Value_new_op(chartoOPERATOR(*token)));
                 l = SubExp_new_layer(l);
             }
             else if (*token == RPAREN) {
-                l = SubExp_collapse(l);
-            } else l = SubExp_add(l, Value_new_op(chartoOPERATOR(*token)));
+                l = close_branches(l);
+                AST_Node open = SubExp_enclosing(l);
+                const char *missing = expected(open);
+                if (missing != NULL) {
+                    if (!malformed) {
+                        Context_error(ctx, "Parsing error: Expected [%s]\n",
+                                           missing);
+                    }
+                    malformed = true;
+                } else if ((open != NULL) && (open->v.type == OP) &&
+                           (open->v.u.op == ARG)) {
+                    if (!malformed && !argument(&l, token, ctx)) {
+                        malformed = true;
+                    }
+                } else l = SubExp_collapse(l);
+            } else l = SubExp_add(l, Value_new_op(symboltoOPERATOR(token)));
         } else if (*token == QUOTE) {
             // fprintf(stdout, "Starting string literal\n");
             l = SubExp_add(l, string(line, token));
@@ -194,18 +307,33 @@ SubExp expression(char **line, char *token)
             if ((last != NULL) && (*last == RPAREN)) {
                 l = SubExp_add(l, Value_new_op(PROD)); 
             }
-            l = SubExp_add(l, Value_new_var(token));
+            OPERATOR op;
+            Value callee = applied(token, *line, ctx, &op);
+            if (callee.type != NONE) {
+                l = call(l, op, callee);
+                // The parenthesis opening the arguments
+                free(token);
+                token = next_token(line);
+            } else l = SubExp_add(l, Value_new_var(token));
         }
         free(last);
         last = token;
     } while (((token = next_token(line)) != NULL) && 
              (isNonLeadingKeyword(token) == NULL));
 
-    if (!SubExp_is_singleton(l)) {
+    l = close_branches(l);
+    const char *missing = expected(SubExp_enclosing(l));
+    if (malformed) {
+        SubExp_free(&l);
+        l = SubExp_new();
+    } else if (!SubExp_is_singleton(l)) {
         SubExp_free(&l);
         l = SubExp_new();
-        fprintf(stderr, "%s [Line %d]: Parsing error: Unclosed parentheses\n",
-                        FILENAME, LINE_NUMBER);
+        if (missing != NULL) {
+            Context_error(ctx, "Parsing error: Expected [%s]\n", missing);
+        } else {
+            Context_error(ctx, "Parsing error: Unclosed parentheses\n");
+        }
     }
 
     // Hacky and bad
@@ -219,6 +347,260 @@ SubExp expression(char **line, char *token)
     return l;
 }
 
+/* if opens a layer for the condition, which then swaps for one holding */
+/* the then branch, which else swaps for one holding the else branch.   */
+/* That last one stays open until whatever closes the layer around the  */
+/* conditional; see close_branches                                      */
+bool conditional(SubExp *l, char *token, CalcContext ctx)
+{
+    if (strcmp(token, IF) == 0) {
+        *l = SubExp_add(*l, Value_new_op(COND));
+        *l = SubExp_new_layer(*l);
+        return true;
+    }
+
+    *l = close_branches(*l);
+    AST_Node open = SubExp_enclosing(*l);
+    bool then = (strcmp(token, THEN) == 0);
+    if ((open == NULL) || (open->v.type != OP) ||
+            (open->v.u.op != (then ? COND : BRANCHES)) ||
+            (open->left != NULL)) {
+        Context_error(ctx, "Parsing error: Unexpected [%s]\n", token);
+        return false;
+    }
+
+    *l = SubExp_detach(*l, &open->left);
+    if (then) open->right = AST_newv(Value_new_op(BRANCHES));
+    *l = SubExp_new_layer(*l);
+    return true;
+}
+
+/* The keyword that must come before the layer hanging from open closes */
+const char *expected(AST_Node open)
+{
+    if ((open == NULL) || (open->v.type != OP)) return NULL;
+    if (open->v.u.op == COND) return THEN;
+    if ((open->v.u.op == BRANCHES) && (open->left == NULL)) return ELSE;
+    return NULL;
+}
+
+/* What token, followed by rest, is applied to arguments as, if anything, */
+/* with *op the call or range made. A name is called if it turns out to  */
+/* be bound to a function, and multiplies its argument otherwise (see    */
+/* evaluate_call), except for the names of the library's functions and  */
+/* of reductions, which are resolved here unless the user's function of  */
+/* the same name is known                                                */
+Value applied(char *token, char *rest, CalcContext ctx, OPERATOR *op)
+{
+    *op = CALL;
+    if (*drop_leading_whitespace(rest) != LPAREN) return NOTHING;
+
+    const Builtin *b = Builtin_find(token);
+    bool reduction = (Range_reduction(token) != NO_REDUCTION);
+    if (((b == NULL) && !reduction) || function_name(token, ctx)) {
+        return Value_new_var(token);
+    }
+    if (b != NULL) return Value_new_builtin(b);
+    *op = RANGE;
+    return Value_new_string(token);
+}
+
+/* Whether token is known to name a function: defined as one by an earlier */
+/* let, or bound to one in the environment, if the parser has one. Without */
+/* one, a name a let bound to anything else cannot be told, and the parse  */
+/* is marked undecided                                                     */
+bool function_name(char *token, CalcContext ctx)
+{
+    Value known = Env_find(ctx->functions, token);
+    if ((known.type == BOOL) && known.u.b) return true;
+    if (ctx->env != NULL) return Env_find(ctx->env, token).type == FUNCTION;
+    if (known.type == BOOL) ctx->undecided = true;
+    return false;
+}
+
+/* The call, or range, hangs what is called from its left, and a layer */
+/* is opened for the first argument                                    */
+SubExp call(SubExp l, OPERATOR op, Value callee)
+{
+    l = SubExp_add(l, Value_new_op(op));
+    l = SubExp_new_layer(l);
+    AST_Node c = SubExp_enclosing(l);
+    c->left = AST_newv(callee);
+    c->right = AST_newv(Value_new_op(ARG));
+    return l;
+}
+
+/* A comma or closing parenthesis ends the argument open in the      */
+/* innermost layer, and a comma opens a layer for another after it   */
+bool argument(SubExp *l, char *token, CalcContext ctx)
+{
+    *l = close_branches(*l);
+    AST_Node open = SubExp_enclosing(*l);
+    const char *missing = expected(open);
+    if (missing != NULL) {
+        Context_error(ctx, "Parsing error: Expected [%s]\n", missing);
+        return false;
+    }
+    if ((open == NULL) || (open->v.type != OP) || (open->v.u.op != ARG)) {
+        Context_error(ctx, "Parsing error: Unexpected [%s]\n", token);
+        return false;
+    }
+
+    *l = SubExp_detach(*l, &open->left);
+    if (open->left == NULL) {
+        Context_error(ctx, "Parsing error: Expected an argument before "
+                           "[%s]\n", token);
+        return false;
+    }
+    if (*token == COMMA) {
+        open->right = AST_newv(Value_new_op(ARG));
+        *l = SubExp_new_layer(*l);
+    }
+    return true;
+}
+
+/* Resolve the index of each range in root, innermost first, to the slot */
+/* of the range's frame. False, once reported, if a range has anything   */
+/* but a name, two bounds and a term for arguments                       */
+bool ranges(AST_Node root, CalcContext ctx)
+{
+    if (root == NULL) return true;
+    if (!ranges(root->left, ctx) || !ranges(root->right, ctx)) return false;
+    if ((root->v.type != OP) || (root->v.u.op != RANGE)) return true;
+
+    AST_Node args[4];
+    unsigned n = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++n) {
+        if (n < 4) args[n] = arg;
+    }
+    AST_Node index = root->right->left;
+    if ((n != 4) || (index->v.type != VAR) || (index->left != NULL) ||
+            (index->right != NULL)) {
+        Context_error(ctx, "Parsing error: [%s] expects an index, two "
+                           "bounds and a term\n", root->left->v.u.s);
+        return false;
+    }
+
+    Scope sc = Scope_new();
+    Scope_add(sc, index->v.u.name, NULL);
+    Scope_resolve(sc, 0, index);
+    Scope_resolve(sc, 0, args[3]->left);
+    Scope_free(&sc);
+    return true;
+}
+
+/* False, once reported, if a conditional in root has a condition that */
+/* is evidently not a boolean, or branches of evidently different types */
+/* or if && or || has an operand that is evidently not a boolean, which */
+/* would otherwise only be found when the left one does not decide      */
+bool conditionals(AST_Node root, CalcContext ctx)
+{
+    if (root == NULL) return true;
+    if (!conditionals(root->left, ctx) || !conditionals(root->right, ctx)) {
+        return false;
+    }
+    if ((root->v.type == OP) && isLogical(root->v.u.op)) {
+        Type l = evident_type(root->left);
+        Type r = evident_type(root->right);
+        Type t = ((l != NONE) && (l != BOOL)) ? l : r;
+        if ((t != NONE) && (t != BOOL)) {
+            Context_error(ctx, "Type mismatch: Operands of [%s] must be of "
+                               "type [%s], not [%s]\n",
+                               OPERATORtosymbol(root->v.u.op),
+                               typestring(BOOL), typestring(t));
+            return false;
+        }
+        return true;
+    }
+    if ((root->v.type != OP) || (root->v.u.op != COND) ||
+            (root->right == NULL)) {
+        return true;
+    }
+
+    Type c = evident_type(root->left);
+    if ((c != NONE) && (c != BOOL)) {
+        Context_error(ctx, "Type mismatch: Condition of [if] must be of "
+                           "type [%s], not [%s]\n", typestring(BOOL),
+                           typestring(c));
+        return false;
+    }
+    Type then = evident_type(root->right->left);
+    Type otherwise = evident_type(root->right->right);
+    if ((then != NONE) && (otherwise != NONE) && (then != otherwise)) {
+        Context_error(ctx, "Type mismatch: Branches of [if] must be of the "
+                           "same type, not [%s] and [%s]\n",
+                           typestring(then), typestring(otherwise));
+        return false;
+    }
+    return true;
+}
+
+/* The type root is bound to have if it is well-typed at all, as far as */
+/* its literals and operators tell, or NONE if that depends on names    */
+Type evident_type(AST_Node root)
+{
+    if (root == NULL) return NONE;
+
+    switch (root->v.type) {
+        case NUMBER:
+        case STRING:
+        case BOOL:
+            return root->v.type;
+        case RELAT_OP:
+            return BOOL;
+        case OP:
+            break;
+        default:
+            return NONE;
+    }
+
+    Type l = evident_type(root->left);
+    Type r = evident_type(root->right);
+    switch (root->v.u.op) {
+        case PAREN:
+            return r;
+        case CONJ:
+        case DISJ:
+            return BOOL;
+        case COND:
+            if (root->right == NULL) return NONE;
+            l = evident_type(root->right->left);
+            r = evident_type(root->right->right);
+            return (l == r) ? l : NONE;
+        case SUM:
+            return ((l == r) && ((l == NUMBER) || (l == STRING))) ? l : NONE;
+        case EXP:
+        case LOG:
+        case MOD:
+        case INT:
+        case PROD:
+        case QUOT:
+        case DIFF:
+            return ((l == NUMBER) && (r == NUMBER)) ? NUMBER : NONE;
+        default:
+            return NONE;
+    }
+}
+
+/* Whether token may name a variable */
+bool name(char *token)
+{
+    return !isDelim(token) && !isNumber(token) && !isKeyword(token) &&
+           !isRelOp(token);
+}
+
+/* Close any else branches left open in the innermost layers */
+SubExp close_branches(SubExp l)
+{
+    AST_Node open;
+    while (((open = SubExp_enclosing(l)) != NULL) &&
+           (open->v.type == OP) && (open->v.u.op == BRANCHES) &&
+           (open->left != NULL)) {
+        l = SubExp_collapse(l);
+    }
+    return l;
+}
+
 Value string(char **line, char *token)
 {
     (void) token;
@@ -229,8 +611,7 @@ Value string(char **line, char *token)
         ++walk;
     }
     ++walk;
-    Value v = {STRING, {.s = copy_nstring(*line, walk - *line - 1)}};
+    Value v = {STRING, false, {.s = copy_nstring(*line, walk - *line - 1)}};
     *line = walk;
     return v;
 }
-
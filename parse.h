@@ -1,10 +1,13 @@
 #ifndef CALC_PARSE_H
 #define CALC_PARSE_H 
 
-#include "subexp.h"
+#include "statement.h"
+#include "context.h"
 
-// Client must free the SubExp returned here
-SubExp parse(char *line, Env e);
+// Client must free the Statement returned here. Nothing is evaluated or
+// bound until the statement is passed to Statement_eval. Syntax errors are
+// reported through ctx
+Statement parse(char *line, CalcContext ctx);
 
 #endif
 
@@ -0,0 +1,354 @@
+#include "profile.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <string.h>
+#include <time.h>
+
+/****************************************************************************/
+
+/* The most lines Profile_report lists */
+static const unsigned REPORT_LINES = 20;
+
+typedef struct Totals {
+    double seconds;
+    unsigned long long nodes;
+    unsigned long long allocations;
+} Totals;
+
+typedef struct Entry {
+    /* NULL for an empty entry */
+    char *key;
+    /* The text of a line */
+    char *text;
+    Totals t;
+} Entry;
+
+/* Open addressed, by key */
+typedef struct Table {
+    Entry *entries;
+    size_t size;
+    size_t capacity;
+} Table;
+
+typedef struct Frame {
+    /* The length of the path up to and including this frame */
+    size_t path_len;
+    double start;
+    unsigned long long nodes;
+    unsigned long long allocations;
+    /* What the frames inside this one took in all */
+    Totals inner;
+} Frame;
+
+struct Profile {
+    /* By filename:line */
+    Table lines;
+    /* By the frames from the line in, separated by ';' */
+    Table stacks;
+
+    char *path;
+    size_t path_cap;
+    Frame *frames;
+    unsigned depth;
+    unsigned max_depth;
+
+    unsigned long long nodes;
+    unsigned long long allocations;
+};
+
+static double now();
+static void   push(Profile p, const char *name);
+static Totals pop(Profile p);
+static void   add(Totals *to, Totals t);
+static Entry *find(Table *t, const char *key);
+static Entry *slot(Table *t, const char *key);
+static char  *copy(const char *str);
+static void   free_table(Table *t);
+static Entry **sorted(Table *t, int (*order)(const void *, const void *));
+static int    by_time(const void *a, const void *b);
+static int    by_key(const void *a, const void *b);
+
+/****************************************************************************/
+
+Profile Profile_new()
+{
+    Profile p = calloc(1, sizeof(*p));
+    if (p == NULL) {
+        perror("Profile_new");
+        exit(EXIT_FAILURE);
+    }
+    p->path_cap = 64;
+    p->path = malloc(p->path_cap);
+    p->max_depth = 16;
+    p->frames = malloc(p->max_depth * sizeof(*p->frames));
+    if ((p->path == NULL) || (p->frames == NULL)) {
+        perror("Profile_new");
+        exit(EXIT_FAILURE);
+    }
+    *p->path = '\0';
+
+    return p;
+}
+
+void Profile_free(Profile *p)
+{
+    if ((p == NULL) || (*p == NULL)) return;
+
+    free_table(&(*p)->lines);
+    free_table(&(*p)->stacks);
+    free((*p)->path);
+    free((*p)->frames);
+    free(*p);
+    *p = NULL;
+}
+
+void Profile_line(Profile p, const char *filename, unsigned line,
+                  const char *text)
+{
+    size_t size = strlen(filename) + 16;
+    char *key = malloc(size);
+    if (key == NULL) {
+        perror("Profile_line");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(key, size, "%s:%u", filename, line);
+
+    p->depth = 0;
+    push(p, key);
+    free(key);
+
+    Entry *e = find(&p->lines, p->path);
+    if (e->text == NULL) e->text = copy(text);
+}
+
+void Profile_end_line(Profile p)
+{
+    if (p->depth == 0) return;
+
+    while (p->depth > 1) Profile_leave(p);
+    Totals t = pop(p);
+    add(&find(&p->lines, p->path)->t, t);
+}
+
+void Profile_enter(Profile p, const char *name)
+{
+    if (p->depth == 0) return;
+
+    p->path[p->frames[p->depth - 1].path_len] = ';';
+    push(p, name);
+}
+
+void Profile_leave(Profile p)
+{
+    if (p->depth <= 1) return;
+
+    Totals t = pop(p);
+    add(&p->frames[p->depth - 1].inner, t);
+    p->path[p->frames[p->depth - 1].path_len] = '\0';
+}
+
+void Profile_node(Profile p)
+{
+    ++p->nodes;
+}
+
+void Profile_allocations(Profile p, unsigned n)
+{
+    p->allocations += n;
+}
+
+void Profile_report(Profile p, FILE *out)
+{
+    Entry **lines = sorted(&p->lines, by_time);
+
+    Totals all = {0, 0, 0};
+    for (size_t i = 0; i < p->lines.size; ++i) add(&all, lines[i]->t);
+
+    fprintf(out, "Profile: %zu line%s, %.6f s, %llu nodes, %llu "
+                 "allocations\n", p->lines.size,
+                 (p->lines.size == 1) ? "" : "s", all.seconds, all.nodes,
+                 all.allocations);
+    fprintf(out, "%12s %7s %14s %12s  %s\n", "seconds", "%", "nodes",
+                 "allocations", "line");
+    for (size_t i = 0; (i < p->lines.size) && (i < REPORT_LINES); ++i) {
+        Totals t = lines[i]->t;
+        double share = (all.seconds > 0) ? 100 * t.seconds / all.seconds : 0;
+        fprintf(out, "%12.6f %6.2f%% %14llu %12llu  %s  %s\n", t.seconds,
+                     share, t.nodes, t.allocations, lines[i]->key,
+                     lines[i]->text);
+    }
+
+    free(lines);
+}
+
+void Profile_stacks(Profile p, FILE *out)
+{
+    Entry **stacks = sorted(&p->stacks, by_key);
+
+    for (size_t i = 0; i < p->stacks.size; ++i) {
+        fprintf(out, "%s %.0f\n", stacks[i]->key,
+                     stacks[i]->t.seconds * 1e6);
+    }
+
+    free(stacks);
+}
+
+/****************************************************************************/
+
+double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Append name to the path, which must already end in a separator if */
+/* there are frames, and open a frame for it                          */
+void push(Profile p, const char *name)
+{
+    size_t from = (p->depth == 0) ? 0 : p->frames[p->depth - 1].path_len;
+    if (p->depth > 0) ++from;
+    size_t len = from + strlen(name);
+    if (len + 2 > p->path_cap) {
+        while (len + 2 > p->path_cap) p->path_cap *= 2;
+        p->path = realloc(p->path, p->path_cap);
+    }
+    if (p->depth == p->max_depth) {
+        p->max_depth *= 2;
+        p->frames = realloc(p->frames, p->max_depth * sizeof(*p->frames));
+    }
+    if ((p->path == NULL) || (p->frames == NULL)) {
+        perror("Profile_enter");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(p->path + from, name);
+
+    Frame *f = &p->frames[p->depth++];
+    f->path_len = len;
+    f->inner = (Totals) {0, 0, 0};
+    f->nodes = p->nodes;
+    f->allocations = p->allocations;
+    f->start = now();
+}
+
+/* Close the innermost frame, crediting what it took less what the frames */
+/* inside it took to its path, and return what it took                   */
+Totals pop(Profile p)
+{
+    Frame *f = &p->frames[--p->depth];
+    Totals t = {now() - f->start, p->nodes - f->nodes,
+                p->allocations - f->allocations};
+
+    Entry *e = find(&p->stacks, p->path);
+    e->t.seconds += t.seconds - f->inner.seconds;
+    e->t.nodes += t.nodes - f->inner.nodes;
+    e->t.allocations += t.allocations - f->inner.allocations;
+
+    return t;
+}
+
+void add(Totals *to, Totals t)
+{
+    to->seconds += t.seconds;
+    to->nodes += t.nodes;
+    to->allocations += t.allocations;
+}
+
+/* The entry for key, made empty if there was none */
+Entry *find(Table *t, const char *key)
+{
+    if (2 * (t->size + 1) > t->capacity) {
+        size_t capacity = (t->capacity == 0) ? 64 : 2 * t->capacity;
+        Table grown = {NULL, t->size, capacity};
+        grown.entries = calloc(grown.capacity, sizeof(*grown.entries));
+        if (grown.entries == NULL) {
+            perror("Profile");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < t->capacity; ++i) {
+            if (t->entries[i].key == NULL) continue;
+            *slot(&grown, t->entries[i].key) = t->entries[i];
+        }
+        free(t->entries);
+        *t = grown;
+    }
+
+    Entry *e = slot(t, key);
+    if (e->key == NULL) {
+        e->key = copy(key);
+        ++t->size;
+    }
+    return e;
+}
+
+/* Where key is in t, or would go. FNV-1a, probed linearly */
+Entry *slot(Table *t, const char *key)
+{
+    size_t h = 2166136261u;
+    for (const char *c = key; *c != '\0'; ++c) {
+        h = (h ^ (unsigned char) *c) * 16777619u;
+    }
+    size_t i = h & (t->capacity - 1);
+    while ((t->entries[i].key != NULL) &&
+            (strcmp(t->entries[i].key, key) != 0)) {
+        i = (i + 1) & (t->capacity - 1);
+    }
+    return &t->entries[i];
+}
+
+/* The profile's own copies are no part of what it measures */
+char *copy(const char *str)
+{
+    char *s = malloc(strlen(str) + 1);
+    if (s == NULL) {
+        perror("Profile");
+        exit(EXIT_FAILURE);
+    }
+    return strcpy(s, str);
+}
+
+void free_table(Table *t)
+{
+    for (size_t i = 0; i < t->capacity; ++i) {
+        free(t->entries[i].key);
+        free(t->entries[i].text);
+    }
+    free(t->entries);
+}
+
+/* The entries of t in order, in an array for the caller to free */
+Entry **sorted(Table *t, int (*order)(const void *, const void *))
+{
+    Entry **entries = malloc((t->size + 1) * sizeof(*entries));
+    if (entries == NULL) {
+        perror("Profile");
+        exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < t->capacity; ++i) {
+        if (t->entries[i].key != NULL) entries[n++] = &t->entries[i];
+    }
+    qsort(entries, n, sizeof(*entries), order);
+    return entries;
+}
+
+/* Longest first, then in the order of filename:line */
+int by_time(const void *a, const void *b)
+{
+    const Entry *x = *(const Entry * const *) a;
+    const Entry *y = *(const Entry * const *) b;
+    if (x->t.seconds != y->t.seconds) {
+        return (x->t.seconds > y->t.seconds) ? -1 : 1;
+    }
+    return by_key(a, b);
+}
+
+int by_key(const void *a, const void *b)
+{
+    const Entry *x = *(const Entry * const *) a;
+    const Entry *y = *(const Entry * const *) b;
+    return strcmp(x->key, y->key);
+}
@@ -0,0 +1,46 @@
+#ifndef CALC_PROFILE_H
+#define CALC_PROFILE_H
+
+#include <stdio.h>
+
+#define T Profile
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Where a run spends its time, by line of the script. Each line is  *
+ * timed from before it is parsed until its result is printed and,   *
+ * for a let, bound, together with the nodes its evaluation visited  *
+ * and the memory it allocated. Within a line, where bindings and    *
+ * calls to functions open frames of their own, for a breakdown in   *
+ * the collapsed-stack form flame graph tools read.                  *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+T    Profile_new();
+void Profile_free(T *p);
+
+/* Attribute what follows to line of filename, whose text is copied, */
+/* until Profile_end_line                                            */
+void Profile_line(T p, const char *filename, unsigned line,
+                  const char *text);
+void Profile_end_line(T p);
+
+/* Open and close a frame, called name, inside the innermost one */
+void Profile_enter(T p, const char *name);
+void Profile_leave(T p);
+
+/* One more node evaluated */
+void Profile_node(T p);
+/* n more blocks of memory allocated: values, bindings, tree nodes, */
+/* or room for frames and tables of the evaluator's                  */
+void Profile_allocations(T p, unsigned n);
+
+/* The lines that took longest, with their share of the whole run */
+void Profile_report(T p, FILE *out);
+/* A line for each stack of frames seen: the frames, separated by ';', */
+/* and the microseconds spent in the innermost one                     */
+void Profile_stacks(T p, FILE *out);
+
+#undef T
+#endif
@@ -0,0 +1,259 @@
+#include "range.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/****************************************************************************/
+
+static const char *NAMES[] = {"sum", "prod", "min", "max"};
+
+/* Terms folded together before their blocks are */
+#define BLOCK 1024
+/* Blocks evaluated before their folds are combined, so that a range of */
+/* any length holds no more than this many at once                      */
+#define WINDOW 4096
+/* Enough partial folds for a range of 2^64 terms */
+#define MAX_PARTIALS 64
+/* Shorter ranges are not worth handing out */
+static const uint64_t PARALLEL_MIN = 16 * BLOCK;
+static const unsigned MAX_THREADS = 64;
+
+/* A range being reduced, shared by the threads working on it */
+typedef struct Work {
+    Reduction r;
+    int64_t lo;
+    /* hi - lo, which one more than may overflow */
+    uint64_t last;
+    Range_term term;
+    void *arg;
+    CalcContext ctx;
+
+    /* The fold of each block of the window being evaluated, the first */
+    /* of which is block first of the range                             */
+    Value *blocks;
+    uint64_t first;
+    uint64_t nblocks;
+
+    pthread_mutex_t lock;
+    uint64_t next;
+    bool failed;
+} Work;
+
+static bool  fold_block(Work *w, uint64_t b, CalcContext ctx,
+                        bool show_errors, bool *complete, Value *terms);
+static bool  fold_parallel(Work *w, unsigned threads);
+static void *helper(void *arg);
+static Value *block_of(uint64_t last);
+static unsigned merge(Reduction r, Value *partials, unsigned depth,
+                      uint64_t b, Value v);
+static Value fold(Reduction r, Value *v, uint64_t n);
+static Value combine(Reduction r, Value lhs, Value rhs);
+
+/****************************************************************************/
+
+Reduction Range_reduction(const char *name)
+{
+    for (unsigned i = 0; i < sizeof(NAMES) / sizeof(*NAMES); ++i) {
+        if (strcmp(name, NAMES[i]) == 0) return (Reduction) i;
+    }
+    return NO_REDUCTION;
+}
+
+Value Range_reduce(Reduction r, int64_t lo, int64_t hi, Range_term term,
+                   void *arg, CalcContext ctx, bool parallel,
+                   bool show_errors, bool *complete)
+{
+    if (hi < lo) {
+        if (r == SUM_OVER) return Value_new_integer(0);
+        if (r == PROD_OVER) return Value_new_integer(1);
+        if (show_errors) {
+            Context_error(ctx, "Runtime error: [%s] of an empty range\n",
+                               NAMES[r]);
+        }
+        return NOTHING;
+    }
+
+    Work w;
+    w.r = r;
+    w.lo = lo;
+    w.last = (uint64_t) hi - (uint64_t) lo;
+    w.term = term;
+    w.arg = arg;
+    w.ctx = ctx;
+    uint64_t nblocks = w.last / BLOCK + 1;
+    uint64_t window = (nblocks < WINDOW) ? nblocks : WINDOW;
+    w.blocks = malloc(window * sizeof(*w.blocks));
+    if (w.blocks == NULL) {
+        perror("Range_reduce");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned threads = ctx->threads;
+    if (threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (n < 1) ? 1 : (n > MAX_THREADS) ? MAX_THREADS : n;
+    }
+    if (threads > window) threads = window;
+    parallel = parallel && (threads > 1) && (w.last >= PARALLEL_MIN - 1);
+
+    Value *terms = block_of(w.last);
+    Context_allocated(ctx, 2);
+    Value partials[MAX_PARTIALS];
+    unsigned depth = 0;
+    for (w.first = 0; w.first < nblocks; w.first += w.nblocks) {
+        w.nblocks = (nblocks - w.first < window) ? nblocks - w.first : window;
+
+        bool done = parallel && fold_parallel(&w, threads);
+        for (uint64_t b = 0; !done && (b < w.nblocks); ++b) {
+            if (!fold_block(&w, b, ctx, show_errors, complete, terms)) {
+                free(terms);
+                free(w.blocks);
+                return NOTHING;
+            }
+        }
+        for (uint64_t b = 0; b < w.nblocks; ++b) {
+            depth = merge(r, partials, depth, w.first + b, w.blocks[b]);
+        }
+    }
+    free(terms);
+    free(w.blocks);
+
+    // The last blocks, which do not fill a power of two, fold right first
+    for (; depth > 1; --depth) {
+        partials[depth - 2] = combine(r, partials[depth - 2],
+                                      partials[depth - 1]);
+    }
+    return partials[0];
+}
+
+/****************************************************************************/
+
+/* Evaluate and fold the terms of block b of the window, using terms to */
+/* hold them                                                            */
+bool fold_block(Work *w, uint64_t b, CalcContext ctx, bool show_errors,
+                bool *complete, Value *terms)
+{
+    uint64_t first = (w->first + b) * BLOCK;
+    uint64_t n = (w->last - first < BLOCK) ? w->last - first + 1 : BLOCK;
+    for (uint64_t i = 0; i < n; ++i) {
+        int64_t index = (int64_t) ((uint64_t) w->lo + first + i);
+        if (!w->term(w->arg, ctx, index, show_errors, complete, &terms[i])) {
+            return false;
+        }
+    }
+    w->blocks[b] = fold(w->r, terms, n);
+    return true;
+}
+
+/* The calling thread and up to threads - 1 helpers take the blocks of */
+/* the window in turn until none are left. False if a term failed       */
+bool fold_parallel(Work *w, unsigned threads)
+{
+    pthread_mutex_init(&w->lock, NULL);
+    w->next = 0;
+    w->failed = false;
+
+    pthread_t helpers[MAX_THREADS];
+    unsigned started = 0;
+    for (; started + 1 < threads; ++started) {
+        if (pthread_create(&helpers[started], NULL, helper, w) != 0) break;
+    }
+    helper(w);
+    for (unsigned i = 0; i < started; ++i) pthread_join(helpers[i], NULL);
+
+    pthread_mutex_destroy(&w->lock);
+    return !w->failed;
+}
+
+/* Terms are evaluated quietly here; any failure is evaluated again */
+void *helper(void *arg)
+{
+    Work *w = arg;
+    CalcContext ctx = Context_new(NULL, NULL, NULL);
+    ctx->env = w->ctx->env;
+    ctx->threads = 1;
+
+    Value *terms = block_of(w->last);
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        uint64_t b = w->next++;
+        bool stop = w->failed || (b >= w->nblocks);
+        pthread_mutex_unlock(&w->lock);
+        if (stop) break;
+
+        bool complete = true;
+        if (!fold_block(w, b, ctx, false, &complete, terms)) {
+            pthread_mutex_lock(&w->lock);
+            w->failed = true;
+            pthread_mutex_unlock(&w->lock);
+        }
+    }
+
+    free(terms);
+    // The environment is only borrowed
+    ctx->env = NULL;
+    Context_free(&ctx);
+    return NULL;
+}
+
+/* Room for the terms of a block of a range whose last is hi - lo */
+Value *block_of(uint64_t last)
+{
+    Value *terms = malloc(((last < BLOCK) ? last + 1 : BLOCK) *
+                          sizeof(*terms));
+    if (terms == NULL) {
+        perror("Range_reduce");
+        exit(EXIT_FAILURE);
+    }
+    return terms;
+}
+
+/* Push v, the fold of block b, onto the depth partial folds of the blocks */
+/* before it, combining equal-sized neighbours as fold would, and return   */
+/* how many there are then: one for each bit set in b + 1                  */
+unsigned merge(Reduction r, Value *partials, unsigned depth, uint64_t b,
+               Value v)
+{
+    partials[depth++] = v;
+    for (uint64_t k = b + 1; k % 2 == 0; k /= 2) {
+        partials[depth - 2] = combine(r, partials[depth - 2],
+                                      partials[depth - 1]);
+        --depth;
+    }
+    return depth;
+}
+
+/* Pairwise, in place, as a balanced tree over v in order */
+Value fold(Reduction r, Value *v, uint64_t n)
+{
+    while (n > 1) {
+        uint64_t half = n / 2;
+        for (uint64_t i = 0; i < half; ++i) {
+            v[i] = combine(r, v[2 * i], v[2 * i + 1]);
+        }
+        if (n % 2 == 1) v[half] = v[n - 1];
+        n -= half;
+    }
+    return v[0];
+}
+
+/* Numbers hold nothing to free, so the operands are simply dropped. Of */
+/* equal numbers, or ones that do not compare, the left one is kept    */
+Value combine(Reduction r, Value lhs, Value rhs)
+{
+    switch (r) {
+        case SUM_OVER:  return Value_combine(lhs, SUM, rhs);
+        case PROD_OVER: return Value_combine(lhs, PROD, rhs);
+        case MIN_OVER:
+            return Value_relate(rhs, LESS_THAN, lhs).u.b ? rhs : lhs;
+        case MAX_OVER:
+            return Value_relate(rhs, GREATER_THAN, lhs).u.b ? rhs : lhs;
+        case NO_REDUCTION:
+            break;
+    }
+    return NOTHING;
+}
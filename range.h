@@ -0,0 +1,43 @@
+#ifndef CALC_RANGE_H
+#define CALC_RANGE_H
+
+#include "context.h"
+#include "value.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Reductions of a term over a range of whole numbers. Terms are     *
+ * folded pairwise in blocks of a fixed size, and the blocks then    *
+ * pairwise in turn, so where rounding happens depends only on the   *
+ * range. That leaves long ranges free to be split by block across   *
+ * threads without changing the result.                              *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef enum Reduction {
+    NO_REDUCTION = -1, SUM_OVER, PROD_OVER, MIN_OVER, MAX_OVER
+} Reduction;
+
+/* The reduction called name, if any */
+Reduction Range_reduction(const char *name);
+
+/* Evaluate the term for index i in ctx into *term, which is then a NUMBER. */
+/* False, once reported if show_errors, if there is none                   */
+typedef bool (*Range_term)(void *arg, CalcContext ctx, int64_t i,
+                           bool show_errors, bool *complete, Value *term);
+
+/* Fold the terms for lo to hi with r, a few thousand blocks at a time,  */
+/* so that however long the range, little is held. If parallel, the      */
+/* terms of a long range are evaluated on helper threads, in contexts of  */
+/* their own that read ctx's environment and nothing else of it. Should   */
+/* any fail there, those of the same blocks are evaluated again in ctx,   */
+/* in order, so that the first failure is the one reported. An empty      */
+/* range sums to 0 and multiplies to 1, but has no minimum or maximum     */
+Value Range_reduce(Reduction r, int64_t lo, int64_t hi, Range_term term,
+                   void *arg, CalcContext ctx, bool parallel,
+                   bool show_errors, bool *complete);
+
+#endif
@@ -0,0 +1,90 @@
+#include "record.h"
+#include "function.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string.h>
+
+/****************************************************************************/
+
+static void write_text(FILE *out, Record r, const char *text, size_t len);
+static size_t unescaped(const char *str, char *buf);
+
+/****************************************************************************/
+
+void Record_header(FILE *out)
+{
+    uint32_t fields[] = {RECORD_VERSION, RECORD_BYTE_ORDER};
+    fwrite(RECORD_MAGIC, 1, 8, out);
+    fwrite(fields, sizeof(fields), 1, out);
+}
+
+void Record_write(FILE *out, unsigned line, Value v)
+{
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.line = line;
+
+    char *text = NULL;
+    size_t len = 0;
+    FILE *printed;
+    switch (v.type) {
+        case NUMBER:
+            r.tag = RECORD_NUMBER;
+            r.u.number = Value_number(v);
+            fwrite(&r, sizeof(r), 1, out);
+            break;
+        case BOOL:
+            r.tag = RECORD_BOOL;
+            r.u.b = v.u.b;
+            fwrite(&r, sizeof(r), 1, out);
+            break;
+        case STRING:
+            r.tag = RECORD_STRING;
+            text = malloc(strlen(v.u.s) + 1);
+            if (text == NULL) {
+                perror("Record_write");
+                exit(EXIT_FAILURE);
+            }
+            write_text(out, r, text, unescaped(v.u.s, text));
+            free(text);
+            break;
+        case FUNCTION:
+            r.tag = RECORD_FUNCTION;
+            printed = open_memstream(&text, &len);
+            if (printed == NULL) {
+                perror("Record_write");
+                exit(EXIT_FAILURE);
+            }
+            Function_print(v.u.fn, printed);
+            fclose(printed);
+            write_text(out, r, text, len);
+            free(text);
+            break;
+        default:
+            break;
+    }
+}
+
+/****************************************************************************/
+
+void write_text(FILE *out, Record r, const char *text, size_t len)
+{
+    static const char PADDING[8] = {0};
+    r.u.length = len;
+    fwrite(&r, sizeof(r), 1, out);
+    fwrite(text, 1, len, out);
+    fwrite(PADDING, 1, (8 - len % 8) % 8, out);
+}
+
+/* str as print_string prints it, into buf; returns the length */
+size_t unescaped(const char *str, char *buf)
+{
+    size_t len = 0;
+    for (const char *walk = str; *walk != '\0'; ++walk) {
+        if (*walk != '\\') buf[len++] = *walk;
+        else if (walk[1] == '\\') buf[len++] = '\\';
+    }
+    return len;
+}
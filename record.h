@@ -0,0 +1,51 @@
+#ifndef CALC_RECORD_H
+#define CALC_RECORD_H
+
+#include "value.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Results written as typed binary records, for programs to read     *
+ * without parsing text. A stream starts with a header and is then   *
+ * one record per result, each a multiple of 8 bytes long so that    *
+ * every record, and the double in it, stays aligned in a mapping of *
+ * the whole stream. Integers and doubles are in the byte order of   *
+ * the machine that wrote them, which the header shows.              *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* The header: MAGIC, then RECORD_VERSION and RECORD_BYTE_ORDER as */
+/* uint32_ts                                                       */
+#define RECORD_MAGIC "CALCBIN\0"
+#define RECORD_VERSION 1
+#define RECORD_BYTE_ORDER 0x01020304
+
+typedef enum Record_tag {
+    RECORD_NUMBER = 1, RECORD_BOOL, RECORD_STRING, RECORD_FUNCTION
+} Record_tag;
+
+/* Every record starts with these 16 bytes. Strings, and functions as */
+/* they would be printed, follow it with length bytes of text and as  */
+/* many zeros as bring the record to a multiple of 8                  */
+typedef struct Record {
+    uint32_t tag;
+    /* The line of the script the result is for, or for an expression */
+    /* evaluated over columns (see columns.h) the row, from 1         */
+    uint32_t line;
+    union {
+        double number;
+        /* 0 or 1 */
+        uint64_t b;
+        uint64_t length;
+    } u;
+} Record;
+
+void Record_header(FILE *out);
+
+/* The record for v, which must be a result Script_statement prints */
+void Record_write(FILE *out, unsigned line, Value v);
+
+#endif
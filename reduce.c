@@ -0,0 +1,134 @@
+
+#include "reduce.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <math.h>
+
+/****************************************************************************/
+
+/* Longer chains would round noticeably more often than pow */
+static const double MAX_CHAIN = 8;
+
+static bool literal(AST_Node root, double *d);
+
+/****************************************************************************/
+
+void Reduce_tree(AST_Node root)
+{
+    if (root == NULL) return;
+
+    Reduce_tree(root->left);
+    Reduce_tree(root->right);
+
+    if ((root->v.type != OP) || (root->left == NULL) ||
+            (root->right == NULL)) {
+        return;
+    }
+
+    double l;
+    double r;
+    bool lhs = literal(root->left, &l);
+    bool rhs = literal(root->right, &r);
+
+    // x + 0 is left alone: it turns a negative zero positive
+    switch (root->v.u.op) {
+        case EXP:
+            if (!rhs) break;
+            if (r == 1) {
+                root->kernel = LEFT;
+            } else if (r == 0.5) {
+                root->kernel = SQUARE_ROOT;
+            } else if ((r >= 2) && (r <= MAX_CHAIN) && (r == floor(r))) {
+                root->kernel = POWER;
+                root->k = r;
+            }
+            break;
+        case LOG:
+            if (!rhs) break;
+            if (r == 2) {
+                root->kernel = LOG2;
+            } else if (r == 10) {
+                root->kernel = LOG10;
+            } else {
+                root->kernel = SCALED_LOG;
+                root->k = 1 / log(r);
+            }
+            break;
+        case PROD:
+            if (rhs && (r == 1)) root->kernel = LEFT;
+            else if (lhs && (l == 1)) root->kernel = RIGHT;
+            break;
+        case QUOT:
+            if (rhs && (r == 1)) root->kernel = LEFT;
+            break;
+        case DIFF:
+            if (rhs && (r == 0)) root->kernel = LEFT;
+            break;
+        default:
+            break;
+    }
+}
+
+Value Reduce_combine(AST_Node root, Value lhs, Value rhs)
+{
+    OPERATOR op = root->v.u.op;
+    if ((root->kernel == GENERAL) || (lhs.type != NUMBER) ||
+            (rhs.type != NUMBER)) {
+        return Value_combine(lhs, op, rhs);
+    }
+
+    // Integers are exact already, and logs of them are no different
+    if (lhs.integral && rhs.integral && (op != LOG)) {
+        return Value_combine(lhs, op, rhs);
+    }
+
+    double x = Value_number(lhs);
+    switch (root->kernel) {
+        case POWER:
+            return Value_new_number(Reduce_power(x, (unsigned) root->k));
+        case SQUARE_ROOT:   return Value_new_number(Reduce_sqrt(x));
+        case LOG2:          return Value_new_number(log2(x));
+        case LOG10:         return Value_new_number(log10(x));
+        case SCALED_LOG:    return Value_new_number(log(x) * root->k);
+        case LEFT:          return Value_new_number(x);
+        case RIGHT:         return Value_new_number(Value_number(rhs));
+        case GENERAL:       break;
+    }
+    return Value_combine(lhs, op, rhs);
+}
+
+/* Exponentiation by squaring, as integer_power does it */
+double Reduce_power(double x, unsigned n)
+{
+    double r = 1;
+    while (true) {
+        if (n & 1) r *= x;
+        n >>= 1;
+        if (n == 0) return r;
+        x *= x;
+    }
+}
+
+/* pow(x, 0.5) is +0 for -0 and +inf for -inf, where sqrt differs */
+double Reduce_sqrt(double x)
+{
+    return (x == -HUGE_VAL) ? HUGE_VAL : sqrt(x + 0.0);
+}
+
+/****************************************************************************/
+
+bool literal(AST_Node root, double *d)
+{
+    while ((root != NULL) && (root->v.type == OP) &&
+            (root->v.u.op == PAREN)) {
+        root = root->right;
+    }
+    if ((root == NULL) || (root->v.type != NUMBER) ||
+            (root->left != NULL) || (root->right != NULL)) {
+        return false;
+    }
+    *d = Value_number(root->v);
+    return true;
+}
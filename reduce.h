@@ -0,0 +1,26 @@
+#ifndef CALC_REDUCE_H
+#define CALC_REDUCE_H 
+
+#include "ast.h"
+#include "value.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Strength reduction. Operators with a literal operand that allows  *
+ * a cheaper computation (x^2, x^0.5, x|2, x*1, ...) get a kernel    *
+ * saying so. The tree itself is left alone, so echoes, type checks  *
+ * and diagnostics are exactly those of the unreduced expression.    *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Choose kernels for every operator in root */
+void  Reduce_tree(AST_Node root);
+
+/* Value_combine for root's operator, by way of its kernel */
+Value Reduce_combine(AST_Node root, Value lhs, Value rhs);
+
+/* The arithmetic of the kernels, for compiled code to share */
+double Reduce_power(double x, unsigned n);
+double Reduce_sqrt(double x);
+
+#endif
@@ -0,0 +1,97 @@
+#include "ring.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <sched.h>
+#include <time.h>
+
+/****************************************************************************/
+
+#define CACHE_LINE 64
+
+/* Each side keeps its own index, and its last sight of the other's, on a */
+/* cache line of its own                                                  */
+struct Ring {
+    void **items;
+    unsigned long mask;
+
+    char pad0[CACHE_LINE];
+    unsigned long head;
+    unsigned long tail_seen;
+
+    char pad1[CACHE_LINE];
+    unsigned long tail;
+    unsigned long head_seen;
+
+    char pad2[CACHE_LINE];
+};
+
+static void backoff(unsigned *spins);
+
+/****************************************************************************/
+
+Ring Ring_new(unsigned capacity)
+{
+    Ring r = malloc(sizeof(*r));
+    unsigned long size = 1;
+    while (size < capacity) size *= 2;
+    if (r != NULL) r->items = malloc(size * sizeof(*r->items));
+    if ((r == NULL) || (r->items == NULL)) {
+        perror("Ring_new");
+        exit(EXIT_FAILURE);
+    }
+    r->mask = size - 1;
+    r->head = r->tail_seen = 0;
+    r->tail = r->head_seen = 0;
+
+    return r;
+}
+
+void Ring_free(Ring *r)
+{
+    if (r == NULL || *r == NULL) return;
+    free((*r)->items);
+    free(*r);
+    *r = NULL;
+}
+
+void Ring_push(Ring r, void *item)
+{
+    unsigned long tail = r->tail;
+    unsigned spins = 0;
+    while (tail - r->head_seen > r->mask) {
+        r->head_seen = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (tail - r->head_seen > r->mask) backoff(&spins);
+    }
+
+    r->items[tail & r->mask] = item;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+void *Ring_pop(Ring r)
+{
+    unsigned long head = r->head;
+    unsigned spins = 0;
+    while (head == r->tail_seen) {
+        r->tail_seen = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (head == r->tail_seen) backoff(&spins);
+    }
+
+    void *item = r->items[head & r->mask];
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return item;
+}
+
+/****************************************************************************/
+
+/* Spin, then yield, then sleep, the longer the other side takes */
+void backoff(unsigned *spins)
+{
+    static const struct timespec NAP = {0, 50000};
+
+    ++*spins;
+    if (*spins < 64) return;
+    else if (*spins < 128) sched_yield();
+    else nanosleep(&NAP, NULL);
+}
@@ -0,0 +1,25 @@
+#ifndef CALC_RING_BUFFER_H
+#define CALC_RING_BUFFER_H 
+
+#define T Ring
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Bounded queue of pointers between exactly one producing thread    *
+ * and one consuming thread. Neither side takes a lock; a side that  *
+ * finds the queue full (or empty) spins briefly, then yields.       *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Holds capacity items, rounded up to a power of two */
+T    Ring_new(unsigned capacity);
+void Ring_free(T *r);
+
+/* Producer only. Waits while the ring is full */
+void  Ring_push(T r, void *item);
+/* Consumer only. Waits while the ring is empty */
+void *Ring_pop(T r);
+
+#undef T
+#endif
@@ -0,0 +1,219 @@
+
+#include "scope.h"
+#include "utility.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string.h>
+
+/****************************************************************************/
+
+static void     resolve(Scope sc, unsigned depth, AST_Node root);
+static void     update_index(Scope sc);
+static unsigned *find(Scope sc, const char *name);
+static size_t   hash_string(const char *s);
+
+static void visit(Scope sc, unsigned i, unsigned char *marks, unsigned *n);
+static void visit_refs(Scope sc, AST_Node root, unsigned depth,
+                       unsigned char *marks, unsigned *n);
+static unsigned range_depth(AST_Node arg, unsigned depth, unsigned i);
+
+/****************************************************************************/
+
+Scope Scope_new()
+{
+    Scope sc = malloc(sizeof(*sc));
+    if (sc == NULL) {
+        perror("Scope_new");
+        exit(EXIT_FAILURE);
+    }
+    sc->size = 0;
+    sc->capacity = 0;
+    sc->names = NULL;
+    sc->exprs = NULL;
+    sc->order = NULL;
+    sc->index = NULL;
+    sc->index_capacity = 0;
+    sc->indexed = 0;
+
+    return sc;
+}
+
+void Scope_free(Scope *sc)
+{
+    if (sc == NULL || *sc == NULL) return;
+
+    for (unsigned i = 0; i < (*sc)->size; ++i) {
+        free((*sc)->names[i]);
+        AST_free(&(*sc)->exprs[i]);
+    }
+    free((*sc)->names);
+    free((*sc)->exprs);
+    free((*sc)->order);
+    free((*sc)->index);
+    free(*sc);
+    *sc = NULL;
+}
+
+void Scope_add(Scope sc, char *name, AST_Node expr)
+{
+    if ((sc == NULL) || (name == NULL)) {
+        AST_free(&expr);
+        return;
+    }
+
+    if (sc->size == sc->capacity) {
+        sc->capacity = (sc->capacity == 0) ? 4 : 2 * sc->capacity;
+        sc->names = realloc(sc->names, sc->capacity * sizeof(*sc->names));
+        sc->exprs = realloc(sc->exprs, sc->capacity * sizeof(*sc->exprs));
+        if ((sc->names == NULL) || (sc->exprs == NULL)) {
+            perror("Scope_add");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    sc->names[sc->size] = copy_string(name);
+    sc->exprs[sc->size] = expr;
+    ++sc->size;
+}
+
+void Scope_resolve(Scope sc, unsigned depth, AST_Node root)
+{
+    if ((sc == NULL) || (root == NULL)) return;
+
+    update_index(sc);
+    resolve(sc, depth, root);
+}
+
+void Scope_order(Scope sc)
+{
+    if (sc == NULL) return;
+
+    free(sc->order);
+    sc->order = malloc((sc->size + 1) * sizeof(*sc->order));
+    unsigned char *marks = calloc(sc->size + 1, sizeof(*marks));
+    if ((sc->order == NULL) || (marks == NULL)) {
+        perror("Scope_order");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned n = 0;
+    for (unsigned i = 0; i < sc->size; ++i) visit(sc, i, marks, &n);
+    free(marks);
+}
+
+void Scope_push(Scope sc, CalcContext ctx)
+{
+    if (sc == NULL) return;
+    Context_allocated(ctx, Stack_push_lazy(ctx->stack, sc->size, sc->exprs));
+}
+
+/****************************************************************************/
+
+/* Depth first, placing slot i after everything it refers to. Marks are 0 */
+/* for slots not yet reached, 1 while their references are followed and  */
+/* 2 once placed, so a cycle is cut where it meets a 1                    */
+void visit(Scope sc, unsigned i, unsigned char *marks, unsigned *n)
+{
+    if (marks[i] != 0) return;
+
+    marks[i] = 1;
+    visit_refs(sc, sc->exprs[i], 0, marks, n);
+    marks[i] = 2;
+    sc->order[(*n)++] = i;
+}
+
+void visit_refs(Scope sc, AST_Node root, unsigned depth,
+                unsigned char *marks, unsigned *n)
+{
+    if (root == NULL) return;
+
+    if ((root->v.type == LOCAL) && (root->v.u.local->depth == depth)) {
+        visit(sc, root->v.u.local->slot, marks, n);
+    }
+    if ((root->v.type == OP) && (root->v.u.op == RANGE)) {
+        unsigned i = 0;
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            visit_refs(sc, arg->left, range_depth(arg, depth, i++), marks, n);
+        }
+        return;
+    }
+    visit_refs(sc, root->left, depth, marks, n);
+    visit_refs(sc, root->right, depth, marks, n);
+}
+
+void resolve(Scope sc, unsigned depth, AST_Node root)
+{
+    if (root == NULL) return;
+
+    // The name of a reduction is no variable
+    if ((root->v.type == OP) && (root->v.u.op == RANGE)) {
+        unsigned i = 0;
+        for (AST_Node arg = root->right; arg != NULL; arg = arg->right) {
+            resolve(sc, range_depth(arg, depth, i++), arg->left);
+        }
+        return;
+    }
+
+    if (root->v.type == VAR) {
+        unsigned *entry = find(sc, root->v.u.name);
+        if (*entry != 0) {
+            Value local = Value_new_local(root->v.u.name, depth, *entry - 1);
+            Value_free(&root->v);
+            root->v = local;
+        }
+    }
+
+    resolve(sc, depth, root->left);
+    resolve(sc, depth, root->right);
+}
+
+/* The depth at which argument i of a range, arg, is read: its bounds  */
+/* are read outside the range's frame and its index and term inside it */
+unsigned range_depth(AST_Node arg, unsigned depth, unsigned i)
+{
+    return ((i == 0) || (arg->right == NULL)) ? depth + 1 : depth;
+}
+
+/* Add the bindings made since the last call, later ones of a name */
+/* shadowing earlier ones                                          */
+void update_index(Scope sc)
+{
+    if (4 * sc->size >= 3 * sc->index_capacity) {
+        unsigned capacity = (sc->index_capacity == 0) ?
+                            16 : 2 * sc->index_capacity;
+        while (4 * sc->size >= 3 * capacity) capacity *= 2;
+        free(sc->index);
+        sc->index = calloc(capacity, sizeof(*sc->index));
+        if (sc->index == NULL) {
+            perror("Scope_resolve");
+            exit(EXIT_FAILURE);
+        }
+        sc->index_capacity = capacity;
+        sc->indexed = 0;
+    }
+
+    for (; sc->indexed < sc->size; ++sc->indexed) {
+        *find(sc, sc->names[sc->indexed]) = sc->indexed + 1;
+    }
+}
+
+/* The entry for name, or the empty one where it would go */
+unsigned *find(Scope sc, const char *name)
+{
+    size_t mask = sc->index_capacity - 1;
+    size_t i = hash_string(name) & mask;
+    while ((sc->index[i] != 0) &&
+           (strcmp(sc->names[sc->index[i] - 1], name) != 0)) {
+        i = (i + 1) & mask;
+    }
+    return &sc->index[i];
+}
+
+size_t hash_string(const char *s)
+{
+    size_t h = 2166136261u;
+    for (; *s != '\0'; ++s) h = (h ^ (unsigned char) *s) * 16777619u;
+    return h;
+}
@@ -0,0 +1,54 @@
+#ifndef CALC_WHERE_SCOPE_H
+#define CALC_WHERE_SCOPE_H 
+
+#include "ast.h"
+#include "context.h"
+
+#define T Scope
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * The bindings introduced by a where clause. Each name owns one     *
+ * slot of a Stack frame; references to it are resolved to that     *
+ * slot when the statement is parsed.                                *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct T {
+    unsigned size;
+    unsigned capacity;
+    char **names;
+    AST_Node *exprs;
+    /* The slots with each after those it refers to, once Scope_order has */
+    /* run. Bindings caught in a cycle come in no particular order        */
+    unsigned *order;
+
+    /* Open addressed table from name to slot + 1 (0 marks an empty entry) */
+    /* covering the first indexed bindings, brought up to date as names   */
+    /* are resolved                                                        */
+    unsigned *index;
+    unsigned index_capacity;
+    unsigned indexed;
+};
+
+T    Scope_new();
+void Scope_free(T *sc);
+
+/* Takes ownership of expr; name is copied */
+void Scope_add(T sc, char *name, AST_Node expr);
+
+/* Rewrite variables in root that name one of sc's bindings into locals */
+/* addressing a frame depth levels out from where root is evaluated     */
+void Scope_resolve(T sc, unsigned depth, AST_Node root);
+
+/* Sort the bindings by the locals (of depth 0) they refer to, once all */
+/* of them are resolved                                                */
+void Scope_order(T sc);
+
+/* Push a frame for the bindings onto ctx's stack. Each is evaluated, at */
+/* most once, when it is first read; see AST_evaluate                   */
+void Scope_push(T sc, CalcContext ctx);
+
+#undef T
+#endif
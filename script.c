@@ -0,0 +1,670 @@
+
+#include "script.h"
+#include "parse.h"
+#include "statement.h"
+#include "basis.h"
+#include "utility.h"
+#include "ring.h"
+#include "function.h"
+#include "number.h"
+#include "record.h"
+#include "jit.h"
+#include "profile.h"
+#include "builtin.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/****************************************************************************/
+
+typedef struct Job {
+    const char *filename;
+    char *out;
+    size_t out_len;
+    char *err;
+    size_t err_len;
+    bool failed;
+    bool done;
+} Job;
+
+typedef struct Batch {
+    Job *jobs;
+    int njobs;
+    int next;
+    VERBOSITY verbosity;
+    ECHO echo;
+    DIGITS digits;
+    OUTPUT output;
+
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} Batch;
+
+typedef struct Line {
+    unsigned int number;
+    /* NULL for an empty line, and once parsed, unless the parse must be */
+    /* left to the evaluator                                             */
+    char *text;
+    Statement st;
+    /* What parsing the line reported, if anything */
+    char *diagnostics;
+} Line;
+
+typedef struct Pipeline {
+    FILE *in;
+    Ring lines;
+    Ring statements;
+
+    /* Reports parse errors into the diagnostics buffer */
+    CalcContext parser;
+    char *diagnostics;
+    size_t diagnostics_size;
+} Pipeline;
+
+static const unsigned PIPELINE_DEPTH = 1024;
+/* Rows a library function's batch form is given at a time */
+#define BATCH_ROWS 1024
+
+static void  begin(CalcContext ctx);
+static void  prompt(CalcContext ctx);
+static void  end(CalcContext ctx);
+static void  run(CalcContext ctx, FILE *in, Columns rows);
+static void  evaluate_rows(CalcContext ctx, Statement st, Columns rows);
+static uint64_t batched(CalcContext ctx, Statement st, const double **from,
+                        const double *numbers, uint64_t nrows);
+static void  print_result(CalcContext ctx, Statement st, Value result);
+static void  echo(CalcContext ctx, Statement st);
+static void  print_value(CalcContext ctx, unsigned line, Value result);
+static void  print_number(CalcContext ctx, double x);
+static void *read_stage(void *arg);
+static void *parse_stage(void *arg);
+static void  run_job(Batch *b, Job *job);
+static void *worker(void *arg);
+
+/****************************************************************************/
+
+void Script_run(CalcContext ctx, FILE *in)
+{
+    run(ctx, in, NULL);
+}
+
+void Script_run_rows(CalcContext ctx, FILE *in, Columns rows)
+{
+    run(ctx, in, rows);
+}
+
+void Script_line(CalcContext ctx, char *line)
+{
+    Statement st = parse(line, ctx);
+    Script_statement(ctx, st);
+    Statement_free(&st);
+}
+
+
+void Script_statement(CalcContext ctx, Statement st)
+{
+    bool complete = true;
+    Value result = Statement_eval(st, ctx, (ctx->verbosity == QUIET) ?
+                                           false : true, &complete);
+
+    if ((ctx->verbosity == VERBOSE) && (st->root != NULL) && !complete) {
+        Context_error(ctx, "Incomplete expression!\n");
+    }
+    if ((ctx->verbosity == VERBOSE) && (st->merged > 0)) {
+        Context_error(ctx, "Shared %u repeated subexpression%s\n",
+                           st->merged, (st->merged == 1) ? "" : "s");
+    }
+
+    print_result(ctx, st, result);
+
+    if (st->name != NULL) {
+        ctx->env = Env_bind(ctx->env, st->name, result);
+        Context_allocated(ctx, 1);
+    } else Value_free(&result);
+}
+
+void Script_run_pipelined(CalcContext ctx, FILE *in)
+{
+    // With one processor the stages could only take turns
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+        Script_run(ctx, in);
+        return;
+    }
+
+    Pipeline p;
+    p.in = in;
+    p.lines = Ring_new(PIPELINE_DEPTH);
+    p.statements = Ring_new(PIPELINE_DEPTH);
+
+    // The parser gets a context of its own, with no environment, since
+    // evaluation runs behind it: it knows only the functions the script's
+    // own lets define or rename (see function_name in parse.c), and
+    // reports its errors into a buffer
+    p.diagnostics = NULL;
+    p.diagnostics_size = 0;
+    FILE *err = open_memstream(&p.diagnostics, &p.diagnostics_size);
+    if (err == NULL) {
+        perror("Script_run_pipelined");
+        exit(EXIT_FAILURE);
+    }
+    p.parser = Context_new(NULL, NULL, err);
+    p.parser->filename = ctx->filename;
+
+    pthread_t reader;
+    pthread_t parser;
+    if ((pthread_create(&reader, NULL, read_stage, &p) != 0) ||
+            (pthread_create(&parser, NULL, parse_stage, &p) != 0)) {
+        perror("Script_run_pipelined");
+        exit(EXIT_FAILURE);
+    }
+
+    begin(ctx);
+
+    Line *line;
+    while ((line = Ring_pop(p.statements)) != NULL) {
+        ctx->line_number = line->number;
+        if (line->diagnostics != NULL) {
+            if (ctx->err != NULL) fputs(line->diagnostics, ctx->err);
+            free(line->diagnostics);
+        }
+        if (line->st != NULL) {
+            Script_statement(ctx, line->st);
+            Statement_free(&line->st);
+        } else if (line->text != NULL) {
+            // Left here for the environment to decide, as it alone does
+            Env_free(&ctx->functions);
+            ctx->functions = Env_new();
+            Script_line(ctx, line->text);
+            free(line->text);
+        }
+        free(line);
+
+        prompt(ctx);
+    }
+
+    end(ctx);
+
+    pthread_join(reader, NULL);
+    pthread_join(parser, NULL);
+    fclose(err);
+    free(p.diagnostics);
+    p.parser->err = NULL;
+    Context_free(&p.parser);
+    Ring_free(&p.lines);
+    Ring_free(&p.statements);
+}
+
+int Script_run_all(char **files, int nfiles, unsigned jobs,
+                   VERBOSITY verbosity, ECHO echo, DIGITS digits,
+                   OUTPUT output)
+{
+    if (nfiles <= 0) return 0;
+    if (jobs == 0) jobs = 1;
+    if (jobs > (unsigned) nfiles) jobs = nfiles;
+
+    Batch b;
+    b.jobs = calloc(nfiles, sizeof(*b.jobs));
+    pthread_t *threads = malloc(jobs * sizeof(*threads));
+    if ((b.jobs == NULL) || (threads == NULL)) {
+        perror("Script_run_all");
+        exit(EXIT_FAILURE);
+    }
+    b.njobs = nfiles;
+    b.next = 0;
+    b.verbosity = verbosity;
+    b.echo = echo;
+    b.digits = digits;
+    b.output = output;
+    pthread_mutex_init(&b.lock, NULL);
+    pthread_cond_init(&b.finished, NULL);
+
+    for (int i = 0; i < nfiles; ++i) b.jobs[i].filename = files[i];
+
+    unsigned started = 0;
+    for (; started < jobs; ++started) {
+        if (pthread_create(&threads[started], NULL, worker, &b) != 0) break;
+    }
+    // Without any helpers the scripts are simply run here
+    if (started == 0) worker(&b);
+
+    // Each script is printed as soon as it and all those before it are done
+    int failures = 0;
+    for (int i = 0; i < nfiles; ++i) {
+        Job *job = &b.jobs[i];
+
+        pthread_mutex_lock(&b.lock);
+        while (!job->done) pthread_cond_wait(&b.finished, &b.lock);
+        pthread_mutex_unlock(&b.lock);
+
+        fwrite(job->out, 1, job->out_len, stdout);
+        fflush(stdout);
+        fwrite(job->err, 1, job->err_len, stderr);
+        if (job->failed) ++failures;
+        free(job->out);
+        free(job->err);
+    }
+
+    for (unsigned i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+
+    pthread_cond_destroy(&b.finished);
+    pthread_mutex_destroy(&b.lock);
+    free(threads);
+    free(b.jobs);
+
+    return failures;
+}
+
+/****************************************************************************/
+
+void begin(CalcContext ctx)
+{
+    if (ctx->output == BINARY) Record_header(ctx->out);
+    prompt(ctx);
+}
+
+void prompt(CalcContext ctx)
+{
+    if ((ctx->verbosity != QUIET) && (ctx->output == TEXT)) {
+        fprintf(ctx->out, "%s", ctx->prompt);
+    }
+    fflush(ctx->out);
+}
+
+void end(CalcContext ctx)
+{
+    if (ctx->output == TEXT) fputc('\n', ctx->out);
+}
+
+void run(CalcContext ctx, FILE *in, Columns rows)
+{
+    char *line = NULL;
+    size_t size = 0;
+    size_t len = 0;
+
+    begin(ctx);
+
+    while ((len = my_getline(&line, &size, in)) != (size_t) -1) {
+        ++ctx->line_number;
+        line[--len] = '\0';
+        if (len == 0) {
+            prompt(ctx);
+            continue;
+        }
+
+        if (ctx->profile != NULL) {
+            Profile_line(ctx->profile, ctx->filename, ctx->line_number, line);
+        }
+
+        Statement st = parse(line, ctx);
+        if ((rows != NULL) && (st->name == NULL) && (st->root != NULL)) {
+            evaluate_rows(ctx, st, rows);
+        } else {
+            Script_statement(ctx, st);
+        }
+        Statement_free(&st);
+
+        if (ctx->profile != NULL) Profile_end_line(ctx->profile);
+
+        prompt(ctx);
+    }
+    free(line);
+
+    end(ctx);
+}
+
+/* st once for each row, with the names of columns bound to the row's */
+/* values. Names bound in neither are left to be reported as unbound  */
+void evaluate_rows(CalcContext ctx, Statement st, Columns rows)
+{
+    Scope names = Scope_new();
+    Scope inputs = Scope_new();
+    Statement_inputs(st, names);
+
+    unsigned n = names->size;
+    int *column = malloc((n + 1) * sizeof(*column));
+    Value *defaults = malloc((n + 1) * sizeof(*defaults));
+    const double **from = malloc((n + 1) * sizeof(*from));
+    double *numbers = malloc((n + 1) * sizeof(*numbers));
+    if ((column == NULL) || (defaults == NULL) || (from == NULL) ||
+            (numbers == NULL)) {
+        perror("evaluate_rows");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned i = 0; i < names->size; ++i) {
+        int c = Columns_find(rows, names->names[i]);
+        Value v = (c < 0) ? Env_find(ctx->env, names->names[i]) : NOTHING;
+        if ((c < 0) && (v.type == NONE)) continue;
+
+        column[inputs->size] = c;
+        defaults[inputs->size] = v;
+        Scope_add(inputs, names->names[i], NULL);
+    }
+    Scope_free(&names);
+    Statement_resolve(st, inputs);
+    n = inputs->size;
+
+    bool numeric = true;
+    for (unsigned i = 0; i < n; ++i) {
+        from[i] = NULL;
+        if (column[i] < 0) {
+            numeric = numeric && (defaults[i].type == NUMBER);
+            numbers[i] = Value_number(defaults[i]);
+        } else if (Columns_type(rows, column[i]) == COLUMN_NUMBER) {
+            from[i] = Columns_numbers(rows, column[i]);
+        } else {
+            numeric = false;
+        }
+    }
+
+    // A library function of columns is applied to blocks of rows at once,
+    // and other rows of numbers are handed to native code where they lie
+    uint64_t nrows = Columns_rows(rows);
+    uint64_t done = numeric ? batched(ctx, st, from, numbers, nrows) : 0;
+    Jit jit = (done < nrows) ? Jit_compile(st, n) : NULL;
+    numeric = numeric && (jit != NULL);
+
+    bool show_errors = (ctx->verbosity != QUIET);
+    bool echoed = false;
+    for (uint64_t r = done; r < nrows; ++r) {
+        Value result;
+        if (numeric) {
+            for (unsigned i = 0; i < n; ++i) {
+                if (from[i] != NULL) numbers[i] = from[i][r];
+            }
+            result = Value_new_number(Jit_run(jit, numbers));
+        } else {
+            Context_allocated(ctx, Stack_push(ctx->stack, n));
+            for (unsigned i = 0; i < n; ++i) {
+                Value *slot = Stack_slot(ctx->stack, 0, i);
+                if (from[i] != NULL) *slot = Value_new_number(from[i][r]);
+                else if (column[i] >= 0) {
+                    *slot = Value_new_bool(
+                                Columns_bools(rows, column[i])[r] != 0);
+                } else *slot = Value_copy(defaults[i]);
+            }
+            result = Statement_eval(st, ctx, show_errors, NULL);
+            Stack_pop(ctx->stack);
+        }
+
+        Type t = result.type;
+        if ((t != NONE) && (t != INVALID)) {
+            if (!echoed && (ctx->output == TEXT)) echo(ctx, st);
+            echoed = true;
+            print_value(ctx, r + 1, result);
+        } else if (show_errors && (t == INVALID)) {
+            Context_error(ctx, "Invalid expression in row %llu\n",
+                               (unsigned long long) r + 1);
+        } else if (show_errors) {
+            Context_error(ctx, "Expression is not well-typed/well-formed "
+                               "in row %llu\n", (unsigned long long) r + 1);
+        }
+        Value_free(&result);
+    }
+
+    Jit_free(&jit);
+    Scope_free(&inputs);
+    free(column);
+    free(defaults);
+    free(from);
+    free(numbers);
+}
+
+/* The rows done, all of them or none: st is printed for each row by its */
+/* library function's batch form if it is a call of one on nothing but  */
+/* inputs, read from from or, where that is NULL, numbers, and numbers  */
+uint64_t batched(CalcContext ctx, Statement st, const double **from,
+                 const double *numbers, uint64_t nrows)
+{
+    AST_Node root = st->root;
+    if ((st->where != NULL) || (root->v.type != OP) ||
+            (root->v.u.op != CALL) || (root->left->v.type != BUILTIN)) {
+        return 0;
+    }
+    const Builtin *b = root->left->v.u.builtin;
+
+    // Each argument is a column, read where it lies, or a constant, spread
+    // over a block of its own
+    const double *column[2];
+    double constant[2][BATCH_ROWS];
+    unsigned n = 0;
+    for (AST_Node arg = root->right; arg != NULL; arg = arg->right, ++n) {
+        if ((n == b->arity) || (arg->left == NULL)) return 0;
+
+        Value v = arg->left->v;
+        column[n] = NULL;
+        if ((v.type == LOCAL) && (from[v.u.local->slot] != NULL)) {
+            column[n] = from[v.u.local->slot];
+            continue;
+        }
+        if (v.type == LOCAL) v = Value_new_number(numbers[v.u.local->slot]);
+        else if (v.type != NUMBER) return 0;
+        for (unsigned i = 0; i < BATCH_ROWS; ++i) {
+            constant[n][i] = Value_number(v);
+        }
+    }
+    if (n != b->arity) return 0;
+
+    double out[BATCH_ROWS];
+    const double *args[2];
+    for (uint64_t r = 0; r < nrows; r += BATCH_ROWS) {
+        size_t rows = (nrows - r < BATCH_ROWS) ? nrows - r : BATCH_ROWS;
+        for (unsigned i = 0; i < n; ++i) {
+            args[i] = (column[i] != NULL) ? column[i] + r : constant[i];
+        }
+        b->batch(args, out, rows);
+
+        if ((r == 0) && (ctx->output == TEXT)) echo(ctx, st);
+        for (size_t i = 0; i < rows; ++i) {
+            print_value(ctx, r + i + 1, Value_new_number(out[i]));
+        }
+    }
+    return nrows;
+}
+
+void print_result(CalcContext ctx, Statement st, Value result)
+{
+    Type t = result.type;
+    if ((t != NONE) && (t != INVALID)) {
+        if (ctx->output == TEXT) echo(ctx, st);
+        print_value(ctx, ctx->line_number, result);
+    } else if (t == INVALID) {
+        if (ctx->verbosity != QUIET)
+            Context_error(ctx, "Invalid expression\n");
+    } else {
+        if (ctx->verbosity != QUIET)
+            Context_error(ctx, "Expression is not well-typed/"
+                               "well-formed\n");
+    }
+}
+
+void echo(CalcContext ctx, Statement st)
+{
+    AST_Node root = st->root;
+
+    if (st->name != NULL) {
+        // Bindings are not echoed
+    } else if ((ctx->echo == YES) &&(ctx->verbosity == NORMAL)) {
+        if ((root->v.type == OP) || (root->v.type == RELAT_OP))
+            AST_print(root, ctx->env, ctx->out);
+    } else if ((ctx->echo == YES) &&(ctx->verbosity == VERBOSE)) {
+        if ((root->v.type == OP) || (root->v.type == RELAT_OP))
+            AST_print_verbose(root, ctx->env, ctx->out);
+    }
+}
+
+/* As text, or as the record for line */
+void print_value(CalcContext ctx, unsigned line, Value result)
+{
+    if (ctx->output == BINARY) {
+        Record_write(ctx->out, line, result);
+        return;
+    }
+
+    switch (result.type) {
+        case NUMBER:
+            print_number(ctx, Value_number(result));
+            break;
+        case STRING:
+            fputc('\"', ctx->out);
+            print_string(result.u.s, ctx->out);
+            fputc('\"', ctx->out);
+            fputc('\n', ctx->out);
+            break;
+        case BOOL:
+            fprintf(ctx->out, "= %s\n", result.u.b ?
+                                        "<True>" : "<False>");
+            break;
+        case FUNCTION:
+            fprintf(ctx->out, "= ");
+            Function_print(result.u.fn, ctx->out);
+            fputc('\n', ctx->out);
+            break;
+        case NONE:
+        case INVALID:
+        case VAR:
+        case OP:
+        case RELAT_OP:
+        case LOCAL:
+        case BUILTIN:
+            Context_error(ctx, "Argh! You've found an interpreter "
+                               "bug: Impossible value\n");
+            break;
+    }
+}
+
+/* Formatted in place and written in one piece */
+void print_number(CalcContext ctx, double x)
+{
+    char line[NUMBER_SIZE + 3] = "= ";
+    size_t len = 2 + Number_format(x, ctx->digits == SHORTEST, line + 2);
+    line[len++] = '\n';
+    fwrite(line, 1, len, ctx->out);
+}
+
+void run_job(Batch *b, Job *job)
+{
+    FILE *out = open_memstream(&job->out, &job->out_len);
+    FILE *err = open_memstream(&job->err, &job->err_len);
+    if ((out == NULL) || (err == NULL)) {
+        perror("Script_run_all");
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *fp = fopen(job->filename, "r");
+    if (fp == NULL) {
+        char reason[256];
+        if (strerror_r(errno, reason, sizeof(reason)) != 0) *reason = '\0';
+        fprintf(err, "%s: %s\n", job->filename, reason);
+        job->failed = true;
+    } else {
+        CalcContext ctx = Context_new(add_basis(Env_new()), out, err);
+        ctx->filename = job->filename;
+        ctx->prompt = "";
+        ctx->verbosity = b->verbosity;
+        ctx->echo = b->echo;
+        ctx->digits = b->digits;
+        ctx->output = b->output;
+
+        Script_run(ctx, fp);
+
+        Context_free(&ctx);
+        fclose(fp);
+    }
+
+    fclose(out);
+    fclose(err);
+}
+
+void *read_stage(void *arg)
+{
+    Pipeline *p = arg;
+
+    char *buf = NULL;
+    size_t size = 0;
+    size_t len = 0;
+    unsigned int number = 0;
+
+    while ((len = my_getline(&buf, &size, p->in)) != (size_t) -1) {
+        Line *line = malloc(sizeof(*line));
+        if (line == NULL) {
+            perror("read_stage");
+            exit(EXIT_FAILURE);
+        }
+        buf[--len] = '\0';
+        line->number = ++number;
+        line->text = (len == 0) ? NULL : copy_nstring(buf, len);
+        line->st = NULL;
+        line->diagnostics = NULL;
+        Ring_push(p->lines, line);
+    }
+    free(buf);
+    Ring_push(p->lines, NULL);
+
+    return NULL;
+}
+
+void *parse_stage(void *arg)
+{
+    Pipeline *p = arg;
+    FILE *err = p->parser->err;
+
+    Line *line;
+    while ((line = Ring_pop(p->lines)) != NULL) {
+        if (line->text != NULL) {
+            p->parser->line_number = line->number;
+            p->parser->undecided = false;
+            line->st = parse(line->text, p->parser);
+
+            // A parse that hinged on a name only the environment can tell
+            // is done again by the evaluator, which has it
+            if (p->parser->undecided) {
+                Statement_free(&line->st);
+                rewind(err);
+            } else {
+                free(line->text);
+                line->text = NULL;
+            }
+
+            // Whatever was reported travels with the statement, to be
+            // printed in order with the output of evaluating it
+            if (ftell(err) > 0) {
+                fputc('\0', err);
+                fflush(err);
+                line->diagnostics = copy_string(p->diagnostics);
+                rewind(err);
+            }
+        }
+        Ring_push(p->statements, line);
+    }
+    Ring_push(p->statements, NULL);
+
+    return NULL;
+}
+
+void *worker(void *arg)
+{
+    Batch *b = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        int i = b->next++;
+        pthread_mutex_unlock(&b->lock);
+        if (i >= b->njobs) break;
+
+        run_job(b, &b->jobs[i]);
+
+        pthread_mutex_lock(&b->lock);
+        b->jobs[i].done = true;
+        pthread_cond_broadcast(&b->finished);
+        pthread_mutex_unlock(&b->lock);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,37 @@
+#ifndef CALC_SCRIPT_H
+#define CALC_SCRIPT_H 
+
+#include "context.h"
+#include "statement.h"
+#include "columns.h"
+
+#include <stdio.h>
+
+/* Interpret every line of in with ctx, printing the prompt, results and */
+/* diagnostics as ctx directs. Binary output starts with its header      */
+void Script_run(CalcContext ctx, FILE *in);
+
+/* As Script_run, but each expression, though not a let, is evaluated */
+/* once for every row of rows, with the names of its columns bound to  */
+/* the row's values, and gives a result for each                       */
+void Script_run_rows(CalcContext ctx, FILE *in, Columns rows);
+
+/* As Script_run, but reading and parsing run ahead of evaluation on */
+/* threads of their own. Output is identical                         */
+void Script_run_pipelined(CalcContext ctx, FILE *in);
+
+/* Interpret one non-empty line, without its newline, and print the result */
+void Script_line(CalcContext ctx, char *line);
+/* Evaluate a parsed line, print the result and bind it if it is a let */
+void Script_statement(CalcContext ctx, Statement st);
+
+/* Run each of nfiles scripts in its own context, seeded with the basis,  */
+/* on up to jobs threads. Each script's output is written to stdout and   */
+/* its diagnostics to stderr in one piece, in the order given, exactly as */
+/* if the scripts had been run one after another. Returns the number of   */
+/* scripts that could not be opened                                      */
+int Script_run_all(char **files, int nfiles, unsigned jobs,
+                   VERBOSITY verbosity, ECHO echo, DIGITS digits,
+                   OUTPUT output);
+
+#endif
@@ -0,0 +1,389 @@
+
+#include "server.h"
+#include "script.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/****************************************************************************/
+
+typedef struct Session {
+    int fd;
+    char name[32];
+    CalcContext ctx;
+
+    /* Received but not yet interpreted */
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+
+    /* Produced but not yet sent */
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+
+    /* Events epoll is currently asked to report */
+    unsigned watching;
+    bool closing;
+
+    struct Session *prev;
+    struct Session *next;
+} Session;
+
+typedef struct Server {
+    int epfd;
+    int lfd;
+    Env basis;
+    VERBOSITY verbosity;
+    ECHO echo;
+    DIGITS digits;
+
+    Session *sessions;
+    unsigned opened;
+} Server;
+
+static const int MAX_EVENTS = 256;
+static const size_t READ_CHUNK = 65536;
+/* A session that has this much unsent output is not read from until the */
+/* client catches up                                                     */
+static const size_t MAX_PENDING = 1 << 20;
+/* A session sending a longer line is told so and closed */
+static const size_t MAX_LINE = 1 << 20;
+
+static volatile sig_atomic_t stopping = 0;
+
+static void on_signal(int sig);
+static int  listen_on(const char *path);
+static void accept_all(Server *srv);
+static bool session_read(Session *s);
+static bool session_write(Session *s);
+static void session_interpret(Session *s, size_t len);
+static void session_overflow(Session *s);
+static void session_queue(Session *s, char *buf, size_t size);
+static void session_watch(Server *srv, Session *s);
+static void session_close(Server *srv, Session *s);
+
+/****************************************************************************/
+
+int Server_run(const char *path, Env basis, VERBOSITY verbosity, ECHO echo,
+               DIGITS digits)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    Server srv;
+    srv.lfd = listen_on(path);
+    if (srv.lfd < 0) return EXIT_FAILURE;
+
+    srv.epfd = epoll_create1(0);
+    if (srv.epfd < 0) {
+        perror("epoll_create1");
+        close(srv.lfd);
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    srv.basis = basis;
+    srv.verbosity = verbosity;
+    srv.echo = echo;
+    srv.digits = digits;
+    srv.sessions = NULL;
+    srv.opened = 0;
+
+    // The listening socket is the only entry without a session
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(srv.epfd, EPOLL_CTL_ADD, srv.lfd, &ev);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int n = epoll_wait(srv.epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Session *s = events[i].data.ptr;
+            if (s == NULL) {
+                accept_all(&srv);
+                continue;
+            }
+
+            bool open = !(events[i].events & EPOLLERR);
+            if (open && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                open = session_read(s);
+            }
+            if (open && (s->out_len > s->out_sent)) open = session_write(s);
+
+            if (!open || (s->closing && (s->out_len == s->out_sent))) {
+                session_close(&srv, s);
+            } else session_watch(&srv, s);
+        }
+    }
+
+    while (srv.sessions != NULL) session_close(&srv, srv.sessions);
+    close(srv.lfd);
+    close(srv.epfd);
+    unlink(path);
+
+    return EXIT_SUCCESS;
+}
+
+/****************************************************************************/
+
+void on_signal(int sig)
+{
+    (void) sig;
+    stopping = 1;
+}
+
+int listen_on(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: Socket path is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // A socket left behind by an earlier server is replaced, other files
+    // are not
+    struct stat st;
+    if ((stat(path, &st) == 0) && S_ISSOCK(st.st_mode)) unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if ((bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) ||
+            (listen(fd, SOMAXCONN) < 0)) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    return fd;
+}
+
+void accept_all(Server *srv)
+{
+    int fd;
+    while ((fd = accept(srv->lfd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        Session *s = calloc(1, sizeof(*s));
+        if (s == NULL) {
+            perror("accept_all");
+            exit(EXIT_FAILURE);
+        }
+        s->fd = fd;
+        snprintf(s->name, sizeof(s->name), "Session %u", ++srv->opened);
+        s->ctx = Context_new(Env_new_extension(srv->basis), NULL, NULL);
+        s->ctx->filename = s->name;
+        s->ctx->prompt = "";
+        s->ctx->verbosity = srv->verbosity;
+        s->ctx->echo = srv->echo;
+        s->ctx->digits = srv->digits;
+
+        s->next = srv->sessions;
+        if (srv->sessions != NULL) srv->sessions->prev = s;
+        srv->sessions = s;
+
+        struct epoll_event ev;
+        ev.events = s->watching = EPOLLIN;
+        ev.data.ptr = s;
+        epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+/* Returns false if the session should be dropped at once */
+bool session_read(Session *s)
+{
+    if (s->closing || (s->out_len - s->out_sent >= MAX_PENDING)) return true;
+
+    if (s->in_cap - s->in_len < READ_CHUNK) {
+        s->in_cap = s->in_len + 2 * READ_CHUNK;
+        s->in = realloc(s->in, s->in_cap);
+        if (s->in == NULL) {
+            perror("session_read");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ssize_t n = read(s->fd, s->in + s->in_len, READ_CHUNK);
+    if (n < 0) {
+        return (errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+               (errno == EINTR);
+    }
+
+    size_t start = s->in_len;
+    s->in_len += n;
+    if (n == 0) {
+        // The last line need not end in a newline
+        if (s->in_len > 0) s->in[s->in_len++] = '\n';
+        s->closing = true;
+    }
+
+    // Only the newly read bytes can complete a line
+    size_t end = s->in_len;
+    while ((end > start) && (s->in[end - 1] != '\n')) --end;
+    if (end > start) session_interpret(s, end);
+    if (!s->closing && (s->in_len > MAX_LINE)) session_overflow(s);
+
+    return true;
+}
+
+/* Interpret the complete lines in the first len bytes of the input */
+void session_interpret(Session *s, size_t len)
+{
+    char *buf = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&buf, &size);
+    if (out == NULL) {
+        perror("session_interpret");
+        exit(EXIT_FAILURE);
+    }
+    s->ctx->out = out;
+    s->ctx->err = out;
+
+    char *line = s->in;
+    char *end = s->in + len;
+    while (line < end) {
+        char *nl = memchr(line, '\n', end - line);
+        *nl = '\0';
+        if ((nl > line) && (nl[-1] == '\r')) nl[-1] = '\0';
+
+        ++s->ctx->line_number;
+        if (*line != '\0') Script_line(s->ctx, line);
+        line = nl + 1;
+    }
+
+    s->ctx->out = NULL;
+    s->ctx->err = NULL;
+    fclose(out);
+
+    memmove(s->in, end, s->in_len - len);
+    s->in_len -= len;
+
+    session_queue(s, buf, size);
+}
+
+/* Report a line too long to take in whole, and close once that is sent */
+void session_overflow(Session *s)
+{
+    char *buf = NULL;
+    size_t size = 0;
+    FILE *err = open_memstream(&buf, &size);
+    if (err == NULL) {
+        perror("session_overflow");
+        exit(EXIT_FAILURE);
+    }
+    s->ctx->err = err;
+    ++s->ctx->line_number;
+    Context_error(s->ctx, "Line longer than %zu bytes\n", MAX_LINE);
+    s->ctx->err = NULL;
+    fclose(err);
+
+    s->in_len = 0;
+    s->closing = true;
+    session_queue(s, buf, size);
+}
+
+/* Queue the size bytes of buf, which is taken over, to be sent */
+void session_queue(Session *s, char *buf, size_t size)
+{
+    if (size == 0) {
+        free(buf);
+    } else if (s->out_len == s->out_sent) {
+        free(s->out);
+        s->out = buf;
+        s->out_len = size;
+        s->out_sent = 0;
+    } else {
+        s->out = realloc(s->out, s->out_len + size);
+        if (s->out == NULL) {
+            perror("session_queue");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(s->out + s->out_len, buf, size);
+        s->out_len += size;
+        free(buf);
+    }
+}
+
+/* Send as much pending output as the socket takes. Returns false if the */
+/* client has gone away                                                  */
+bool session_write(Session *s)
+{
+    while (s->out_sent < s->out_len) {
+        ssize_t n = send(s->fd, s->out + s->out_sent,
+                         s->out_len - s->out_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+        }
+        s->out_sent += n;
+    }
+
+    free(s->out);
+    s->out = NULL;
+    s->out_len = 0;
+    s->out_sent = 0;
+
+    return true;
+}
+
+/* Read while the client keeps up with the output, write while there is */
+/* output left                                                          */
+void session_watch(Server *srv, Session *s)
+{
+    unsigned want = 0;
+    if (!s->closing && (s->out_len - s->out_sent < MAX_PENDING)) {
+        want |= EPOLLIN;
+    }
+    if (s->out_len > s->out_sent) want |= EPOLLOUT;
+    if (want == s->watching) return;
+
+    struct epoll_event ev;
+    ev.events = s->watching = want;
+    ev.data.ptr = s;
+    epoll_ctl(srv->epfd, EPOLL_CTL_MOD, s->fd, &ev);
+}
+
+void session_close(Server *srv, Session *s)
+{
+    if (s->prev != NULL) s->prev->next = s->next;
+    else srv->sessions = s->next;
+    if (s->next != NULL) s->next->prev = s->prev;
+
+    epoll_ctl(srv->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    Context_free(&s->ctx);
+    free(s->in);
+    free(s->out);
+    free(s);
+}
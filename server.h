@@ -0,0 +1,20 @@
+#ifndef CALC_SERVER_H
+#define CALC_SERVER_H 
+
+#include "context.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Serve interpreter sessions over a Unix domain socket. Every       *
+ * connection is a session with its own environment extending basis, *
+ * which is shared by all of them and never modified. Lines are      *
+ * interpreted as they arrive and their output, diagnostics included,*
+ * is sent back on the same connection.                              *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Runs until interrupted (SIGINT or SIGTERM). Returns an exit status */
+int Server_run(const char *path, Env basis, VERBOSITY verbosity, ECHO echo,
+               DIGITS digits);
+
+#endif
@@ -0,0 +1,170 @@
+
+#include "stack.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+/****************************************************************************/
+
+static const unsigned INIT_SLOTS = 64;
+static const unsigned INIT_FRAMES = 16;
+
+struct Stack {
+    Value *slots;
+    /* In step with slots */
+    SlotState *states;
+    struct AST_Node **thunks;
+    unsigned size;
+    unsigned capacity;
+
+    /* Index of the first slot of each frame */
+    unsigned *frames;
+    /* In step with frames: the frame each was pushed inside of, plus one */
+    unsigned *parents;
+    unsigned depth;
+    unsigned max_depth;
+    /* The frame locals are read from, plus one (0 for none) */
+    unsigned current;
+};
+
+static unsigned frame(Stack s, unsigned depth);
+
+/****************************************************************************/
+
+Stack Stack_new()
+{
+    Stack s = malloc(sizeof(*s));
+    if (s == NULL) {
+        perror("Stack_new");
+        exit(EXIT_FAILURE);
+    }
+
+    s->slots = malloc(INIT_SLOTS * sizeof(*s->slots));
+    s->states = malloc(INIT_SLOTS * sizeof(*s->states));
+    s->thunks = malloc(INIT_SLOTS * sizeof(*s->thunks));
+    s->frames = malloc(INIT_FRAMES * sizeof(*s->frames));
+    s->parents = malloc(INIT_FRAMES * sizeof(*s->parents));
+    if ((s->slots == NULL) || (s->states == NULL) || (s->thunks == NULL) ||
+            (s->frames == NULL) || (s->parents == NULL)) {
+        perror("Stack_new");
+        exit(EXIT_FAILURE);
+    }
+    s->size = 0;
+    s->capacity = INIT_SLOTS;
+    s->depth = 0;
+    s->max_depth = INIT_FRAMES;
+    s->current = 0;
+
+    return s;
+}
+
+void Stack_free(Stack *s)
+{
+    if (s == NULL || *s == NULL) return;
+    while ((*s)->depth > 0) Stack_pop(*s);
+    free((*s)->slots);
+    free((*s)->states);
+    free((*s)->thunks);
+    free((*s)->frames);
+    free((*s)->parents);
+    free(*s);
+    *s = NULL;
+}
+
+unsigned Stack_push(Stack s, unsigned size)
+{
+    unsigned grown = Stack_push_lazy(s, size, NULL);
+    for (unsigned i = s->frames[s->depth - 1]; i < s->size; ++i) {
+        s->states[i] = BOUND;
+    }
+    return grown;
+}
+
+unsigned Stack_push_lazy(Stack s, unsigned size, struct AST_Node **exprs)
+{
+    unsigned grown = 0;
+    if (s->depth == s->max_depth) {
+        s->max_depth *= 2;
+        s->frames = realloc(s->frames, s->max_depth * sizeof(*s->frames));
+        s->parents = realloc(s->parents,
+                             s->max_depth * sizeof(*s->parents));
+        if ((s->frames == NULL) || (s->parents == NULL)) {
+            perror("Stack_push");
+            exit(EXIT_FAILURE);
+        }
+        grown += 2;
+    }
+    if (s->size + size > s->capacity) {
+        while (s->size + size > s->capacity) s->capacity *= 2;
+        s->slots = realloc(s->slots, s->capacity * sizeof(*s->slots));
+        s->states = realloc(s->states, s->capacity * sizeof(*s->states));
+        s->thunks = realloc(s->thunks, s->capacity * sizeof(*s->thunks));
+        if ((s->slots == NULL) || (s->states == NULL) ||
+                (s->thunks == NULL)) {
+            perror("Stack_push");
+            exit(EXIT_FAILURE);
+        }
+        grown += 3;
+    }
+
+    s->parents[s->depth] = s->current;
+    s->frames[s->depth++] = s->size;
+    s->current = s->depth;
+    for (unsigned i = 0; i < size; ++i) {
+        s->states[s->size] = UNEVALUATED;
+        s->thunks[s->size] = (exprs != NULL) ? exprs[i] : NULL;
+        s->slots[s->size++] = NOTHING;
+    }
+    return grown;
+}
+
+void Stack_pop(Stack s)
+{
+    if (s->depth == 0) return;
+
+    unsigned base = s->frames[--s->depth];
+    s->current = s->parents[s->depth];
+    while (s->size > base) Value_free(&s->slots[--s->size]);
+}
+
+unsigned Stack_depth(Stack s)
+{
+    return s->depth;
+}
+
+unsigned Stack_enter(Stack s, unsigned depth)
+{
+    unsigned entered = s->current;
+    s->current = frame(s, depth) + 1;
+    return entered;
+}
+
+void Stack_leave(Stack s, unsigned entered)
+{
+    s->current = entered;
+}
+
+Value *Stack_slot(Stack s, unsigned depth, unsigned slot)
+{
+    return &s->slots[s->frames[frame(s, depth)] + slot];
+}
+
+SlotState *Stack_state(Stack s, unsigned depth, unsigned slot)
+{
+    return &s->states[s->frames[frame(s, depth)] + slot];
+}
+
+struct AST_Node *Stack_thunk(Stack s, unsigned depth, unsigned slot)
+{
+    return s->thunks[s->frames[frame(s, depth)] + slot];
+}
+
+/****************************************************************************/
+
+/* The index of the frame depth levels out from the current one */
+unsigned frame(Stack s, unsigned depth)
+{
+    unsigned f = s->current;
+    while (depth-- > 0) f = s->parents[f - 1];
+    return f - 1;
+}
@@ -0,0 +1,55 @@
+#ifndef CALC_FRAME_STACK_H
+#define CALC_FRAME_STACK_H 
+
+#include "value.h"
+
+#define T Stack
+typedef struct T *T;
+
+struct AST_Node;
+
+/* Where a lazily bound slot has got to. Slots of frames pushed with */
+/* Stack_push are BOUND from the start                               */
+typedef enum SlotState {UNEVALUATED, IN_PROGRESS, BOUND} SlotState;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * Runtime storage for names resolved to (depth, slot) at parse time.*
+ * Frames are laid out contiguously in one array that is reused from *
+ * statement to statement, so binding a local costs a store. Where   *
+ * clauses push lazy frames, whose slots are bound when first read.  *
+ * Depths count along the frames each one was pushed inside of,      *
+ * which are those below it unless another frame was entered.        *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+T    Stack_new();
+void Stack_free(T *s);
+
+/* Push a frame of size empty (NONE) slots. Both pushes return how many */
+/* of s's arrays had to be allocated again to make room for the frame   */
+unsigned Stack_push(T s, unsigned size);
+/* Push a frame of size UNEVALUATED slots, to be bound to the values of */
+/* exprs, which must outlive the frame, as they are first read          */
+unsigned Stack_push_lazy(T s, unsigned size, struct AST_Node **exprs);
+/* Pop the innermost frame, freeing the values it holds */
+void Stack_pop(T s);
+
+/* The number of frames pushed and not yet popped */
+unsigned Stack_depth(T s);
+
+/* Read locals as if the frame depth levels out were the innermost one, */
+/* until Stack_leave is given what this returns. Frames pushed in the   */
+/* meantime are pushed inside that one, and must be popped before then  */
+unsigned Stack_enter(T s, unsigned depth);
+void     Stack_leave(T s, unsigned entered);
+
+/* Slot in the frame depth levels out from the innermost one. The pointer
+ * is only valid until the next push */
+Value *Stack_slot(T s, unsigned depth, unsigned slot);
+/* The state of the same slot, and the expression it is to be bound to */
+SlotState *Stack_state(T s, unsigned depth, unsigned slot);
+struct AST_Node *Stack_thunk(T s, unsigned depth, unsigned slot);
+
+#undef T
+#endif
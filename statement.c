@@ -0,0 +1,106 @@
+
+#include "statement.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string.h>
+
+/****************************************************************************/
+
+static void free_vars(Scope inputs, AST_Node root);
+
+/****************************************************************************/
+
+Statement Statement_new()
+{
+    Statement st = malloc(sizeof(*st));
+    if (st == NULL) {
+        perror("Statement_new");
+        exit(EXIT_FAILURE);
+    }
+    st->name = NULL;
+    st->root = NULL;
+    st->where = NULL;
+    st->merged = 0;
+
+    return st;
+}
+
+void Statement_free(Statement *st)
+{
+    if (st == NULL || *st == NULL) return;
+
+    free((*st)->name);
+    AST_free(&(*st)->root);
+    Scope_free(&(*st)->where);
+    free(*st);
+    *st = NULL;
+}
+
+Value Statement_eval(Statement st, CalcContext ctx, bool show_errors,
+                     bool *complete)
+{
+    if (st == NULL) {
+        if (complete != NULL) *complete = false;
+        return NOTHING;
+    }
+
+    if (st->where != NULL) Scope_push(st->where, ctx);
+
+    Value v = AST_evaluate(st->root, ctx, show_errors, complete);
+
+    if (st->where != NULL) Stack_pop(ctx->stack);
+
+    return v;
+}
+
+bool Statement_well_formed(Statement st)
+{
+    if ((st == NULL) || !AST_well_formed(st->root)) return false;
+
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        if (!AST_well_formed(st->where->exprs[i])) return false;
+    }
+    return true;
+}
+
+void Statement_inputs(Statement st, Scope inputs)
+{
+    if (st == NULL) return;
+
+    free_vars(inputs, st->root);
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        free_vars(inputs, st->where->exprs[i]);
+    }
+}
+
+void Statement_resolve(Statement st, Scope inputs)
+{
+    if (st == NULL) return;
+
+    // Inputs sit one frame outside the where clause, if there is one
+    unsigned depth = (st->where != NULL) ? 1 : 0;
+    Scope_resolve(inputs, depth, st->root);
+    for (unsigned i = 0; (st->where != NULL) && (i < st->where->size); ++i) {
+        Scope_resolve(inputs, depth, st->where->exprs[i]);
+    }
+}
+
+/****************************************************************************/
+
+void free_vars(Scope inputs, AST_Node root)
+{
+    if (root == NULL) return;
+
+    if (root->v.type == VAR) {
+        bool seen = false;
+        for (unsigned i = 0; (i < inputs->size) && !seen; ++i) {
+            seen = (strcmp(inputs->names[i], root->v.u.name) == 0);
+        }
+        if (!seen) Scope_add(inputs, root->v.u.name, NULL);
+    }
+
+    free_vars(inputs, root->left);
+    free_vars(inputs, root->right);
+}
@@ -0,0 +1,49 @@
+#ifndef CALC_STATEMENT_H
+#define CALC_STATEMENT_H 
+
+#include "ast.h"
+#include "context.h"
+#include "scope.h"
+
+#include <stdbool.h>
+
+#define T Statement
+typedef struct T *T;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                                                                   *
+ * A parsed line: an expression, the name it is bound to if the line *
+ * is a let, and the bindings of its where clause, if any.           *
+ *                                                                   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+struct T {
+    char *name;
+    AST_Node root;
+    Scope where;
+    /* Subexpressions parsing merged into identical ones elsewhere in the */
+    /* statement                                                         */
+    unsigned merged;
+};
+
+T    Statement_new();
+void Statement_free(T *st);
+
+/* Evaluate the where clause into a fresh frame of ctx's stack, then the  */
+/* expression (see AST_evaluate). Binding a let's result is left to the   */
+/* caller                                                                 */
+Value Statement_eval(T st, CalcContext ctx, bool show_errors, bool *complete);
+
+/* Whether st's expression and each binding of its where clause are    */
+/* well formed (see AST_well_formed)                                    */
+bool  Statement_well_formed(T st);
+
+/* Add each name st reads from the environment to inputs, unless it is */
+/* there already                                                       */
+void  Statement_inputs(T st, Scope inputs);
+/* Rewrite st's references to inputs into locals of a frame pushed just */
+/* before st is evaluated, outside its where clause (see Jit_compile)   */
+void  Statement_resolve(T st, Scope inputs);
+
+#undef T
+#endif
@@ -42,7 +42,7 @@ void SubExp_print(SubExp s)
 void SubExp_print_r(SubExp s)
 {
     if (s == NULL) return;
-    AST_print(s->head);
+    AST_print(s->head, NULL, stdout);
     SubExp_print(s->rest);
 }
 
@@ -88,21 +88,34 @@ SubExp SubExp_collapse(SubExp s)
     return second;
 }
 
-AST_Node SubExp_toAST(SubExp s)
+AST_Node SubExp_enclosing(SubExp s)
 {
-    if (s == NULL) return NULL;
+    if ((s == NULL) || (s->rest == NULL)) return NULL;
+    return AST_rightmost(s->rest->head);
+}
 
-    if (SubExp_is_singleton(s)) {
-        return AST_copy(s->head);
-    } else {
-        return SubExp_toAST(SubExp_collapse(s));
+SubExp SubExp_detach(SubExp s, AST_Node *tree)
+{
+    if (s == NULL) {
+        *tree = NULL;
+        return NULL;
     }
+
+    *tree = s->head;
+    return SubExp_pop(s);
 }
 
-void SubExp_replace_vars(SubExp s, Env e)
+AST_Node SubExp_toAST(SubExp *s)
 {
-    if ((s == NULL) || (e == NULL)) return;
-    AST_replace_vars(s->head, e);
+    if (s == NULL || *s == NULL) return NULL;
+
+    while (!SubExp_is_singleton(*s)) *s = SubExp_collapse(*s);
+
+    AST_Node root = (*s)->head;
+    (*s)->head = NULL;
+    SubExp_free(s);
+
+    return root;
 }
 
 bool SubExp_is_singleton(SubExp s)
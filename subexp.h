@@ -20,8 +20,13 @@ SubExp SubExp_add(SubExp s, Value v);
 
 SubExp SubExp_collapse(SubExp s);
 
-AST_Node SubExp_toAST(SubExp s);
-void     SubExp_replace_vars(SubExp s, Env e);
+/* The node SubExp_collapse would hang the innermost layer from, if any */
+AST_Node SubExp_enclosing(SubExp s);
+/* Pop the innermost layer, handing its tree over to the caller */
+SubExp SubExp_detach(SubExp s, AST_Node *tree);
+
+// Consumes s, handing its tree over to the caller
+AST_Node SubExp_toAST(SubExp *s);
 
 bool SubExp_is_singleton(SubExp s);
 
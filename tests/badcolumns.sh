@@ -0,0 +1,24 @@
+# Files of columns that are missing, malformed or truncated are refused
+# with a reason, before any of the script is run
+dir=$(mktemp -d)
+echo 'x + y' > "$dir/script"
+patched() {
+    cp tests/columns.col "$dir/$1"
+    printf "$3" | dd of="$dir/$1" bs=1 seek=$2 conv=notrunc 2>/dev/null
+}
+head -c 20 tests/columns.col > "$dir/short"
+head -c 200 tests/columns.col > "$dir/truncated"
+patched magic 0 'X'
+patched version 8 '\002'
+patched descriptors 12 '\077'
+patched type 56 '\003'
+patched name 24 '\000'
+patched offset 64 '\001'
+for f in missing short truncated magic version descriptors type name offset
+do
+    { ./calc --columns "$dir/$f" "$dir/script"; echo "exit $?"; } 2>&1 |
+    sed "s|$dir/||"
+done
+./calc --columns tests/columns.col "$dir/script" "$dir/script" 2>&1 |
+sed "s|$dir/||"
+rm -rf "$dir"
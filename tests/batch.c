@@ -0,0 +1,140 @@
+#include "context.h"
+#include "columns.h"
+#include "script.h"
+#include "basis.h"
+#include "env.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/****************************************************************************/
+
+/* More than two blocks of rows, the last of them partial */
+#define NROWS 2500
+
+/* Each call is made on blocks of rows; the same call in a where clause */
+/* is made a row at a time                                              */
+static const char *CALLS[] = {
+    "atan2(y, x)",
+    "hypot(x, 3)",
+    "sqrt(y)",
+    "exp(y)",
+    "floor(x)",
+    "pow(x, k)",
+    "pow(k, y)",
+};
+
+static void put(FILE *f, uint64_t v, int bytes);
+static void write_columns(const char *path);
+static char *run(Columns rows, const char *script);
+
+/****************************************************************************/
+
+int main(void)
+{
+    char path[] = "/tmp/calc-batch-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    write_columns(path);
+
+    Columns rows = Columns_open(path, stderr);
+    if (rows == NULL) return EXIT_FAILURE;
+
+    for (size_t i = 0; i < sizeof(CALLS) / sizeof(*CALLS); ++i) {
+        char script[128];
+        snprintf(script, sizeof(script), "let k = 2\n%s\n", CALLS[i]);
+        char *batched = run(rows, script);
+        snprintf(script, sizeof(script), "let k = 2\n%s where u = 0\n",
+                 CALLS[i]);
+        char *single = run(rows, script);
+
+        // The first and last few rows, and whether all of them agree
+        char *end = batched;
+        for (int n = 0; (n < 4) && (end = strchr(end, '\n')) != NULL; ++n) {
+            ++end;
+        }
+        printf("%s\n%.*s...\n", CALLS[i], (int) (end - batched), batched);
+        int length = strlen(batched);
+        while ((length > 0) && (batched[length - 1] == '\n')) --length;
+        char *last = batched + length;
+        while ((last > batched) && (last[-1] != '\n')) --last;
+        printf("%.*s\n%s\n", (int) (batched + length - last), last,
+               (strcmp(batched, single) == 0) ? "same" : "differs");
+        free(batched);
+        free(single);
+    }
+
+    Columns_free(&rows);
+    remove(path);
+
+    return 0;
+}
+
+
+void put(FILE *f, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) fputc((v >> (8 * i)) & 0xff, f);
+}
+
+
+void write_columns(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *names[] = {"x", "y"};
+    fwrite(COLUMNS_MAGIC, 1, 8, f);
+    put(f, COLUMNS_VERSION, 4);
+    put(f, 2, 4);
+    put(f, NROWS, 8);
+    for (int c = 0; c < 2; ++c) {
+        char name[COLUMNS_NAME_SIZE] = {0};
+        strcpy(name, names[c]);
+        fwrite(name, 1, sizeof(name), f);
+        put(f, COLUMN_NUMBER, 4);
+        put(f, 0, 4);
+        put(f, 24 + 2 * 48 + c * NROWS * sizeof(double), 8);
+    }
+    for (int c = 0; c < 2; ++c) {
+        for (int i = 0; i < NROWS; ++i) {
+            double d = (c == 0) ? i * 0.37 - 400 : (i % 17) * 1.5;
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            put(f, bits, 8);
+        }
+    }
+
+    fclose(f);
+}
+
+
+char *run(Columns rows, const char *script)
+{
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    FILE *in = fmemopen((void *) script, strlen(script), "r");
+    if ((out == NULL) || (in == NULL)) {
+        perror("run");
+        exit(EXIT_FAILURE);
+    }
+
+    CalcContext ctx = Context_new(add_basis(Env_new()), out, out);
+    ctx->echo = NO;
+    Script_run_rows(ctx, in, rows);
+    Context_free(&ctx);
+
+    fclose(in);
+    fclose(out);
+    return text;
+}
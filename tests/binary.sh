@@ -0,0 +1,20 @@
+# Records of each type, each for its line, with errors left out of the
+# records and reported as text, and with -j an output for each script
+script=$(mktemp)
+cat > "$script" <<'END'
+1.5
+let b = 1 < 2
+"abc"
+let f(x) = x + 1
+nosuch + 1
+"exactly8"
+(0 - 1) / (1e200 * 1e200)
+END
+./calc --output=binary "$script" 2>/dev/null | od -An -tx1 -v
+./calc --output=binary "$script" 2>&1 >/dev/null | sed "s|$script|script|"
+./calc --output=binary --output=text "$script" 2>/dev/null | head -n 2
+other=$(mktemp)
+printf '2\n3\n' > "$other"
+./calc -j 2 --output=binary "$script" "$other" 2>/dev/null | tail -c 48 |
+od -An -tx1 -v
+rm -f "$script" "$other"
@@ -0,0 +1,67 @@
+#include "libcalc.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+/****************************************************************************/
+
+#define NTHREADS 4
+static const int ROUNDS = 2000;
+
+static void *run(void *arg);
+
+/****************************************************************************/
+
+int main(void)
+{
+    // Handles interleaved on one thread keep their own bindings
+    calc_expr *a = calc_compile("x + 1");
+    calc_expr *b = calc_compile("x * 2 where x = 10");
+    calc_binding x = {"x", {CALC_NUMBER, {5}}};
+    printf("%g %g %g\n", calc_eval(a, &x, 1).u.number,
+           calc_eval(b, &x, 1).u.number, calc_eval(a, &x, 1).u.number);
+    calc_free(a);
+    calc_free(b);
+
+    pthread_t threads[NTHREADS];
+    int ids[NTHREADS];
+    for (int i = 0; i < NTHREADS; ++i) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, run, &ids[i]);
+    }
+    for (int i = 0; i < NTHREADS; ++i) {
+        void *failures;
+        pthread_join(threads[i], &failures);
+        printf("thread %d: %s\n", i, (failures == NULL) ? "ok" : "failed");
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/* Evaluates a handle of its own over and over, interpreted since it makes */
+/* strings; returns non-NULL if any result was wrong                       */
+void *run(void *arg)
+{
+    int id = *(int *) arg;
+    calc_expr *e = calc_compile("if n > k then \"big\" else \"small\" "
+                                "where k = 1000 * id");
+    calc_binding b[] = {{"n", {CALC_NUMBER, {0}}},
+                        {"id", {CALC_NUMBER, {id}}}};
+
+    bool failed = false;
+    for (int i = 0; i < ROUNDS; ++i) {
+        b[0].value.u.number = id * 1000 + (i % 2) * 2 - 1;
+        calc_value v = calc_eval(e, b, 2);
+        const char *expected = (i % 2) ? "big" : "small";
+        if ((v.type != CALC_STRING) || (v.u.string[0] != expected[0])) {
+            failed = true;
+        }
+    }
+    calc_free(e);
+
+    return failed ? arg : NULL;
+}
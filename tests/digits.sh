@@ -0,0 +1,32 @@
+# Results across the range of magnitudes must print as %.15g prints
+# them, and with --shortest as the first of %.15g, %.16g and %.17g
+# that reads back exactly
+script=$(mktemp)
+awk 'BEGIN {
+    srand(2)
+    for (i = 0; i < 4000; ++i) {
+        n = 1 + int(rand() * 20)
+        s = ""
+        for (j = 0; j < n; ++j) s = s int(rand() * 10)
+        if (i % 3 == 0) s = "0." substr("000000000000", 1, int(rand() * 12)) s
+        else if (i % 3 == 1) s = s "e" int(rand() * 300)
+        print s
+    }
+}' > "$script"
+for digits in "" --shortest; do
+    ./calc -q --no-echo $digits "$script" | paste -d ' ' "$script" - |
+    awk -v shortest="$digits" '{
+        if (NF != 3) next
+        n++
+        x = $1 + 0
+        want = sprintf("%.15g", x)
+        if (shortest != "" && want + 0 != x) want = sprintf("%.16g", x)
+        if (shortest != "" && want + 0 != x) want = sprintf("%.17g", x)
+        if ($3 != want) {
+            print "printed differently: " $1 " as " $3 ", not " want
+            bad++
+        }
+    }
+    END { print n " results, " (bad + 0) " printed differently" }'
+done
+rm -f "$script"
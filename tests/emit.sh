@@ -0,0 +1,17 @@
+# Each script, transpiled to C and compiled, must print what it does
+# when interpreted, both to standard output and to standard error
+dir=$(mktemp -d)
+for t in evaluate echo rebind where conditionals functions logic ranges \
+        reduce lazy shortcircuit lazyif memo; do
+    ./calc tests/$t.calc > "$dir/out" 2> "$dir/err"
+    ./calc --emit-c tests/$t.calc > "$dir/$t.c" &&
+    ${CC:-cc} -std=c99 -O1 -w -o "$dir/$t" "$dir/$t.c" -lm &&
+    "$dir/$t" > "$dir/emitted.out" 2> "$dir/emitted.err"
+    if cmp -s "$dir/out" "$dir/emitted.out" &&
+            cmp -s "$dir/err" "$dir/emitted.err"; then
+        echo "$t: same"
+    else
+        echo "$t: differs"
+    fi
+done
+rm -rf "$dir"
@@ -0,0 +1,45 @@
+#include "libcalc.h"
+
+#include <stdio.h>
+
+/****************************************************************************/
+
+/* Arithmetic on numbers alone, which is run as native code where there is */
+/* a compiler for it, and must give what the interpreter does              */
+static const char *EXPRESSIONS[] = {
+    "x + y * 2 - x / y",
+    "(x - y) * (x + y) / 3",
+    "x ^ 2 + y ^ 0.5",
+    "x % 3 + y % 2",
+    "(abs(x) + 1) | 2",
+    "sqrt(x * x + y * y) + atan2(y, x)",
+    "floor(x / y) + abs(y - x) + pow(x, 3)",
+    "a * x + b where a = 2 and b = a + y",
+    "x * x * x * x * x * x - (x * x * x) * (x * x * x)",
+    "sum(i, 1, 10, x * i) + max(i, 0, 3, y - i)",
+    NULL
+};
+
+static const double POINTS[][2] = {{3, 4}, {-2.5, 0.125}, {0, 1}, {1e10, 7}};
+
+/****************************************************************************/
+
+int main(void)
+{
+    calc_binding b[] = {{"x", {CALC_NUMBER, {0}}}, {"y", {CALC_NUMBER, {0}}}};
+
+    for (int i = 0; EXPRESSIONS[i] != NULL; ++i) {
+        calc_expr *e = calc_compile(EXPRESSIONS[i]);
+        printf("%s\n", EXPRESSIONS[i]);
+        for (size_t p = 0; p < sizeof(POINTS) / sizeof(*POINTS); ++p) {
+            b[0].value.u.number = POINTS[p][0];
+            b[1].value.u.number = POINTS[p][1];
+            calc_value v = calc_eval(e, b, 2);
+            if (v.type == CALC_NUMBER) printf("    %.17g\n", v.u.number);
+            else printf("    error\n");
+        }
+        calc_free(e);
+    }
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+# Scripts run on several threads are printed in the order given, each
+# with its output ahead of its diagnostics
+./calc -j 3 tests/where.calc tests/rebind.calc tests/echo.calc
+echo "exit $?"
+./calc -j 8 tests/echo.calc tests/echo.calc
+echo "exit $?"
+./calc -j 2 tests/echo.calc tests/missing.calc
+echo "exit $?"
@@ -0,0 +1,74 @@
+#include "libcalc.h"
+
+#include <stdio.h>
+
+/****************************************************************************/
+
+static void compile(const char *src);
+
+/****************************************************************************/
+
+int main(void)
+{
+    // Well formed
+    compile("1 + 2");
+    compile("sqrt(4)");
+    compile("sum(i, 1, 3, i)");
+    compile("x where x = 2");
+    compile("x * (y + 1)");
+
+    // Malformed
+    compile("1 +");
+    compile("* 2");
+    compile("1 2");
+    compile("()");
+    compile("if 1 < 2 then 3");
+    compile("sum(i, 1, 3)");
+    compile("x where x = 1 +");
+    compile("");
+
+    calc_expr *e = calc_compile("x * (y + 1)");
+    calc_binding b[] = {{"x", {CALC_NUMBER, {2}}}, {"y", {CALC_NUMBER, {3}}}};
+    for (int i = 0; i < 3; ++i) {
+        b[1].value.u.number = i;
+        printf("x * (y + 1) at y = %d: %g\n", i, calc_eval(e, b, 2).u.number);
+    }
+    calc_free(e);
+
+    // Strings and booleans are interpreted, and unbound names fall back
+    // to the built-in constants
+    e = calc_compile("if c then s + \"!\" else t where t = \"no\"");
+    for (size_t i = 0; i < calc_nvars(e); ++i) {
+        printf("input %zu: %s\n", i, calc_varname(e, i));
+    }
+    calc_binding c[] = {{"c", {CALC_BOOL, {0}}}, {"s", {CALC_STRING, {0}}}};
+    c[1].value.u.string = "yes";
+    c[0].value.u.boolean = 1;
+    printf("%s\n", calc_eval(e, c, 2).u.string);
+    c[0].value.u.boolean = 0;
+    printf("%s\n", calc_eval(e, c, 2).u.string);
+    printf("type without c: %d\n", calc_eval(e, c + 1, 1).type);
+    calc_free(e);
+
+    e = calc_compile("2 * PI");
+    printf("2 * PI = %.15g\n", calc_eval(e, NULL, 0).u.number);
+    calc_free(e);
+
+    return 0;
+}
+
+/****************************************************************************/
+
+void compile(const char *src)
+{
+    calc_expr *e = calc_compile(src);
+    if (e == NULL) {
+        printf("[%s] NULL\n", src);
+        return;
+    }
+
+    calc_value v = calc_eval(e, NULL, 0);
+    if (v.type == CALC_NUMBER) printf("[%s] = %g\n", src, v.u.number);
+    else printf("[%s] compiled, %zu inputs\n", src, calc_nvars(e));
+    calc_free(e);
+}
@@ -0,0 +1,17 @@
+# A script longer than the pipeline between reading, parsing and
+# evaluating holds, with errors and deferred lines along the way
+script=$(mktemp)
+awk 'BEGIN {
+    print "let f(x) = x + 1"
+    print "let c = 1 < 2"
+    for (i = 1; i <= 3000; ++i) {
+        if (i % 1000 == 0) print "x +"
+        else if (i % 750 == 0) print "let sqrt = if c then f else f"
+        else print "let x = " i
+    }
+    print "x * 2"
+    print "sqrt(x)"
+}' > "$script"
+./calc -q "$script" | tail -n 3
+./calc "$script" 2>&1 >/dev/null | sed "s|$script|script|"
+rm -f "$script"
@@ -0,0 +1,26 @@
+# Long literals, across the range of exponents, must each read as the
+# double strtod makes of them, shown by both printing it alike
+script=$(mktemp)
+awk 'BEGIN {
+    srand(1)
+    for (i = 0; i < 4000; ++i) {
+        n = 1 + int(rand() * 30)
+        s = ""
+        for (j = 0; j < n; ++j) s = s int(rand() * 10)
+        point = int(rand() * (n + 1))
+        s = substr(s, 1, point) "." substr(s, point + 1)
+        if (i % 2) s = s "e" int(rand() * 290)
+        print s
+    }
+}' > "$script"
+./calc -q --shortest --no-echo "$script" | paste -d ' ' "$script" - |
+awk '{
+    if (NF != 3) next
+    n++
+    if (sprintf("%.17g", $1 + 0) != sprintf("%.17g", $3 + 0)) {
+        print "read differently: " $1 " as " $3
+        bad++
+    }
+}
+END { print n " literals, " (bad + 0) " read differently" }'
+rm -f "$script"
@@ -0,0 +1,25 @@
+# What each line evaluated and allocated, and the frames its time was
+# spent in; the times themselves, and so the order, vary from run to run
+dir=$(mktemp -d)
+cat > "$dir/script" <<'END'
+let memo fib(n) = if n < 2 then n else fib(n - 1) + fib(n - 2)
+fib(10)
+let g(n) = n * k where k = 2
+sum(i, 1, 1000, g(i))
+"a" + "b"
+1 +
+x where x = 3
+END
+./calc --profile="$dir/stacks" "$dir/script" 2>"$dir/report" >/dev/null
+awk '/^Profile:/ { print $1, $2, $3, $6, $7, $8, $9 }' "$dir/report"
+sed "s|$dir/||" "$dir/report" | awk '
+    /^Profile:/ { report = 1; next }
+    !report || /seconds/ || NF == 0 { next }
+    { row = $3; for (i = 4; i <= NF; ++i) row = row " " $i; print row }
+' | sort -t: -k2 -n
+sed "s|$dir/||" "$dir/stacks" | awk '
+    $NF !~ /^[0-9]+$/ { print "not microseconds: " $0 }
+    { sub(/ [^ ]*$/, ""); print }
+'
+./calc --profile "$dir/script" "$dir/script" 2>&1 | sed "s|$dir/||"
+rm -rf "$dir"
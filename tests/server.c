@@ -0,0 +1,100 @@
+#include "server.h"
+#include "basis.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/****************************************************************************/
+
+static int  connect_to(const char *path);
+static void converse(int fd, const char *text, size_t len);
+
+/****************************************************************************/
+
+int main(void)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/calc-test-%ld.sock", (long) getpid());
+
+    pid_t server = fork();
+    if (server == 0) {
+        _exit(Server_run(path, add_basis(Env_new()), NORMAL, YES,
+                         ROUNDED));
+    }
+
+    // Sessions are interpreted side by side, each with its own bindings
+    int first = connect_to(path);
+    int second = connect_to(path);
+    const char *a = "let x = 3\nx * 2\n";
+    const char *b = "x + 1\n1 +\n";
+    if ((first < 0) || (second < 0)) return EXIT_FAILURE;
+    send(first, a, strlen(a), MSG_NOSIGNAL);
+    converse(second, b, strlen(b));
+    converse(first, "x * PI", 6);
+
+    // A line too long to take in ends the session
+    size_t len = 3 << 20;
+    char *flood = malloc(len);
+    memset(flood, '1', len);
+    converse(connect_to(path), flood, len);
+    free(flood);
+
+    kill(server, SIGTERM);
+    int status;
+    waitpid(server, &status, 0);
+    printf("server exited with %d\n", WIFEXITED(status) ?
+                                      WEXITSTATUS(status) : -1);
+    printf("socket %s\n", (access(path, F_OK) == 0) ? "left" : "removed");
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/* A connection to the server at path, once it is listening */
+int connect_to(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    struct timespec pause = {0, 10000000};
+    for (int tries = 0; tries < 200; ++tries) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        nanosleep(&pause, NULL);
+    }
+    return -1;
+}
+
+/* Send text, the last of the session, and print all that comes back */
+void converse(int fd, const char *text, size_t len)
+{
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(fd, text + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    shutdown(fd, SHUT_WR);
+
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) fwrite(buf, 1, n, stdout);
+    fflush(stdout);
+    close(fd);
+}
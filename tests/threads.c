@@ -0,0 +1,72 @@
+#include "context.h"
+#include "script.h"
+#include "basis.h"
+#include "env.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************/
+
+static const char *LINES[] = {
+    "sum(i, 1, 3000000, i)",
+    "sum(i, 1, 3000000, 1 / i)",
+    "prod(i, 1, 100000, 1 + 1 / (i * i))",
+    "min(i, 0 - 100000, 100000, (i - 777) * (i - 777))",
+    "max(i, 1, 1000000, (i * 7919) % 1000003)",
+    "sum(i, 1, 100000, if i % 3 = 0 then i else 0 - i)",
+    "sum(i, 1, 200000, i * k) where k = 3",
+    "let f(n) = n * n",
+    "sum(i, 1, 100000, f(i))",
+    "sum(i, 1, 100000, sum(j, 1, i % 5, j))",
+    "sum(i, 1, 100000, if i = 90000 then \"a\" else i)",
+    "min(i, 1, 100000, if i = 50000 then j else i)",
+};
+
+static char *run(unsigned threads);
+
+/****************************************************************************/
+
+int main(void)
+{
+    // Whatever the processors here, a long range must reduce to the same
+    // result on one thread as on several
+    char *one = run(1);
+    fputs(one, stdout);
+
+    const unsigned THREADS[] = {2, 4, 7};
+    for (size_t i = 0; i < sizeof(THREADS) / sizeof(*THREADS); ++i) {
+        char *several = run(THREADS[i]);
+        printf("%u threads: %s\n", THREADS[i],
+               (strcmp(one, several) == 0) ? "same" : "differs");
+        free(several);
+    }
+    free(one);
+
+    return 0;
+}
+
+
+char *run(unsigned threads)
+{
+    char *text = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&text, &size);
+    if (out == NULL) {
+        perror("run");
+        exit(EXIT_FAILURE);
+    }
+
+    CalcContext ctx = Context_new(add_basis(Env_new()), out, out);
+    ctx->threads = threads;
+    for (size_t i = 0; i < sizeof(LINES) / sizeof(*LINES); ++i) {
+        char line[256];
+        strcpy(line, LINES[i]);
+        Script_line(ctx, line);
+    }
+    Context_free(&ctx);
+
+    fclose(out);
+    return text;
+}
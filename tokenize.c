@@ -14,8 +14,11 @@ char *next_token(char **str)
     char *start = drop_leading_whitespace(*str);
     if (*start == '\0') return NULL;
     if (isDelim(start)) {
-        *str = start + 1;
-        return copy_nstring(start, 1);
+        // && and || are the only delimiters two characters long
+        size_t len = (((*start == '&') || (*start == '|')) &&
+                      (start[1] == *start)) ? 2 : 1;
+        *str = start + len;
+        return copy_nstring(start, len);
     } else {
         *str = find_next(start, isDelim);
         return copy_nstring(start, (*str - start));
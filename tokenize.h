@@ -6,7 +6,7 @@
 
 #include <stdbool.h>
 
-static const char DELIMS[] = " =\"!<>";
+static const char DELIMS[] = " =\"!<>,";
 static const char ASSIGN = '=';
 static const char QUOTE = '"';
 static const char ESCAPE = '\\';
@@ -14,6 +14,8 @@ static const char ESCAPE = '\\';
 static const char LET[] = "let";
 static const char WHERE[] = "where";
 static const char AND[] = "and";
+/* Follows let in the definition of a function that remembers its results */
+static const char MEMO[] = "memo";
 
 static const char *LEADING_KEYWORDS[] = 
 {
@@ -30,6 +32,19 @@ static const char *NONLEADING_KEYWORDS[] =
 static unsigned int NUM_NONLEADING_KEYWORDS = 
     (sizeof(NONLEADING_KEYWORDS) / sizeof(char *));
 
+static const char IF[] = "if";
+static const char THEN[] = "then";
+static const char ELSE[] = "else";
+
+/* These may appear anywhere an operand may */
+static const char *CONDITIONAL_KEYWORDS[] = 
+{
+    IF, THEN, ELSE
+};
+
+static const unsigned int NUM_CONDITIONAL_KEYWORDS =
+    (sizeof(CONDITIONAL_KEYWORDS) / sizeof(char *));
+
 static const char NOT[] = "!";
 static const char IS_EQUAL[] = "=";
 static const char IS_NOT_EQUAL[] = "!=";
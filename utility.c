@@ -1,6 +1,7 @@
 
 #include "utility.h"
 #include "tokenize.h"
+#include "number.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -10,11 +11,6 @@
 
 /****************************************************************************/
 
-unsigned int LINE_NUMBER = 0;
-char *FILENAME = "Standard Input";
-
-/****************************************************************************/
-
 char *copy_string(const char *str)
 {
     if (str == NULL) return NULL;
@@ -29,7 +25,7 @@ char *copy_string(const char *str)
     }
 
     for (i = 0; str[i] != '\0'; ++i) {
-        if (i == size) {
+        if (i + 1 == size) {
             buf = realloc(buf, 2 * size);
             size *= 2;
             if (buf == NULL) {
@@ -74,7 +70,7 @@ char *combine_string(char *start, char *second)
     size_t l1 = strlen(start);
     size_t l2 = strlen(second);
 
-    char *buf = malloc(((l1 * l2) * sizeof(*buf)) + 1);
+    char *buf = malloc(((l1 + l2) * sizeof(*buf)) + 1);
     strncpy(buf, start, l1);
     strncpy(buf + l1, second, l2 + 1);
 
@@ -199,7 +195,7 @@ char *isKeyword(char *token)
             return token;
         }
     }
-    return NULL;
+    return isConditionalKeyword(token);
 }
 
 char *isLeadingKeyword(char *token)
@@ -234,13 +230,19 @@ char *isNonLeadingKeyword(char *token)
     return NULL;
 }
 
+char *isConditionalKeyword(char *token)
+{
+    if (token == NULL) return NULL;
+
+    for (unsigned i = 0; i < NUM_CONDITIONAL_KEYWORDS; ++i) {
+        if (strcmp(CONDITIONAL_KEYWORDS[i], token) == 0) return token;
+    }
+    return NULL;
+}
 
 bool isNumber(char *token)
 {
-    if (token == NULL) return false;
-    char *end = NULL;
-    strtod(token, &end);
-    return *end == '\0';
+    return (token != NULL) && Number_parse(token, NULL);
 }
 
 char *isRelOp(char *str)
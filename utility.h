@@ -5,9 +5,6 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-extern unsigned int LINE_NUMBER;
-extern char *FILENAME;
-
 /****************************************************************************/
 
 typedef char *condition(char *c);
@@ -36,6 +33,7 @@ char *isKeyword(char *token);
 char *hasKeyword(char *token);
 char *isLeadingKeyword(char *token);
 char *isNonLeadingKeyword(char *token);
+char *isConditionalKeyword(char *token);
 bool  isNumber(char *token);
 char *isRelOp(char *str);
 char *hasRelOp(char *str);
@@ -1,5 +1,7 @@
 
 #include "value.h"
+#include "function.h"
+#include "builtin.h"
 #include "utility.h"
 
 #include <stdlib.h>
@@ -18,6 +20,9 @@ static const char *VAR_S = "VARIABLE";
 static const char *BOOL_S = "BOOLEAN";
 static const char *OP_S = "OPERATOR";
 static const char *RELAT_OP_S = "RELATIONAL_OPERATOR";
+static const char *LOCAL_S = "LOCAL_VARIABLE";
+static const char *FUNCTION_S = "FUNCTION";
+static const char *BUILTIN_S = "BUILTIN_FUNCTION";
 
 const char *typestring(Type t)
 {
@@ -30,6 +35,9 @@ const char *typestring(Type t)
         case BOOL:      return BOOL_S;
         case OP:        return OP_S;
         case RELAT_OP:  return RELAT_OP_S;
+        case LOCAL:     return LOCAL_S;
+        case FUNCTION:  return FUNCTION_S;
+        case BUILTIN:   return BUILTIN_S;
     }
     // Compiler dummy
     return NONE_S;
@@ -46,6 +54,9 @@ bool is_literal_type(Type t)
         case BOOL:      return true;
         case OP:        return false;
         case RELAT_OP:  return false;
+        case LOCAL:     return true;
+        case FUNCTION:  return true;
+        case BUILTIN:   return true;
     }
     // Compiler dummy
     return false;
@@ -54,7 +65,11 @@ bool is_literal_type(Type t)
 /****************************************************************************/
 
 static double do_math(double lhs, OPERATOR op, double rhs);
+static bool   do_integer_math(int64_t lhs, OPERATOR op, int64_t rhs,
+                              int64_t *result);
+static bool   integer_power(int64_t base, int64_t exp, int64_t *result);
 static bool   relate(double lhs, RELOP op, double rhs);
+static bool   relate_integers(int64_t lhs, RELOP op, int64_t rhs);
 static bool   cmp_strings(char *lhs, RELOP op, char *rhs);
 static bool   combine_bool(bool lhs, RELOP op, bool rhs);
 
@@ -62,39 +77,76 @@ static bool   combine_bool(bool lhs, RELOP op, bool rhs);
 
 Value Value_new_number(double d)
 {
-    Value v = {NUMBER, {.d = d}};
+    Value v = {NUMBER, false, {.d = d}};
+    return v;
+}
+
+Value Value_new_integer(int64_t i)
+{
+    Value v = {NUMBER, true, {.i = i}};
     return v;
 }
 
 Value Value_new_string(const char *s)
 {
     if (s == NULL) return NOTHING;
-    Value v = {STRING, {.s = copy_string(s)}};
+    Value v = {STRING, false, {.s = copy_string(s)}};
     return v;
 }
 
 Value Value_new_op(OPERATOR op)
 {
-    Value v = {OP, {.op = op}};
+    Value v = {OP, false, {.op = op}};
     return v;
 }
 
 Value Value_new_var(char *name)
 {
     if (name == NULL) return NOTHING;
-    Value v = {VAR, {.name = copy_string(name)}};
+    Value v = {VAR, false, {.name = copy_string(name)}};
     return v;
 }
 
 Value Value_new_bool(bool b)
 {
-    Value v = {BOOL, {.b = b}};
+    Value v = {BOOL, false, {.b = b}};
     return v;
 }
 
 Value Value_new_relop(RELOP r)
 {
-    Value v = {RELAT_OP, {.rop = r}};
+    Value v = {RELAT_OP, false, {.rop = r}};
+    return v;
+}
+
+Value Value_new_local(char *name, unsigned depth, unsigned slot)
+{
+    if (name == NULL) return NOTHING;
+
+    Local *l = malloc(sizeof(*l));
+    if (l == NULL) {
+        perror("Value_new_local");
+        exit(EXIT_FAILURE);
+    }
+    l->name = copy_string(name);
+    l->depth = depth;
+    l->slot = slot;
+
+    Value v = {LOCAL, false, {.local = l}};
+    return v;
+}
+
+Value Value_new_function(struct Function *fn)
+{
+    if (fn == NULL) return NOTHING;
+    Value v = {FUNCTION, false, {.fn = fn}};
+    return v;
+}
+
+Value Value_new_builtin(const struct Builtin *b)
+{
+    if (b == NULL) return NOTHING;
+    Value v = {BUILTIN, false, {.builtin = b}};
     return v;
 }
 
@@ -108,17 +160,35 @@ Value Value_copy(Value v)
         case VAR:
             n.u.name = copy_string(v.u.name);
             break;
+        case LOCAL:
+            n = Value_new_local(v.u.local->name, v.u.local->depth,
+                                v.u.local->slot);
+            break;
+        case FUNCTION:
+            n.u.fn = Function_share(v.u.fn);
+            break;
         default: return n;
     }
     return n;
 }
 
+double Value_number(Value v)
+{
+    return v.integral ? (double) v.u.i : v.u.d;
+}
+
 void Value_free(Value *v)
 {
     if (v == NULL) return;
     switch (v->type) {
         case STRING:    free(v->u.s); break;
         case VAR:       free(v->u.name); break;
+        case LOCAL:
+            free(v->u.local->name);
+            free(v->u.local);
+            break;
+        case FUNCTION:  Function_free(&v->u.fn); break;
+        case BUILTIN:
         case OP:
         case RELAT_OP:
         case NUMBER:
@@ -136,11 +206,20 @@ Value Value_combine(Value lhs, OPERATOR op, Value rhs)
 
     switch (rhs.type) {
         case NUMBER:
-            return Value_new_number(do_math(lhs.u.d, op, rhs.u.d));
+            if (lhs.integral && rhs.integral &&
+                    do_integer_math(lhs.u.i, op, rhs.u.i, &v.u.i)) {
+                return Value_new_integer(v.u.i);
+            }
+            return Value_new_number(do_math(Value_number(lhs), op,
+                                            Value_number(rhs)));
         case STRING:
             v.type = STRING;
             v.u.s = combine_string(lhs.u.s, rhs.u.s);
             return v;
+        case BOOL:
+            if (op == CONJ) return Value_new_bool(lhs.u.b && rhs.u.b);
+            if (op == DISJ) return Value_new_bool(lhs.u.b || rhs.u.b);
+            return NOTHING;
         case OP:
         default: return NOTHING;
     }
@@ -151,7 +230,12 @@ Value Value_relate(Value lhs, RELOP op, Value rhs)
     if (lhs.type != rhs.type) return NOTHING;
 
     switch (rhs.type) {
-        case NUMBER: return Value_new_bool(relate(lhs.u.d, op, rhs.u.d));
+        case NUMBER:
+            if (lhs.integral && rhs.integral) {
+                return Value_new_bool(relate_integers(lhs.u.i, op, rhs.u.i));
+            }
+            return Value_new_bool(relate(Value_number(lhs), op,
+                                         Value_number(rhs)));
         case STRING: return Value_new_bool(cmp_strings(lhs.u.s, op, rhs.u.s));
         case BOOL:   return Value_new_bool(combine_bool(lhs.u.b, op, rhs.u.b));
         default: return NOTHING;
@@ -161,13 +245,17 @@ Value Value_relate(Value lhs, RELOP op, Value rhs)
 void Value_print(Value v)
 {
     switch (v.type) {
-        case NUMBER:    fprintf(stdout, "[%g]", v.u.d); break;
+        case NUMBER:    fprintf(stdout, "[%g]", Value_number(v)); break;
         case STRING:    fprintf(stdout, "[%s]", v.u.s); break;
         case VAR:       fprintf(stdout, "[%s]", v.u.name); break;
         case BOOL:      fprintf(stdout, "[%s]", v.u.name ? "true" : "false");
                             break;
-        case OP:        fprintf(stdout, "[%c]", OPERATORtochar(v.u.op)); break;
+        case OP:        fprintf(stdout, "[%s]", OPERATORtosymbol(v.u.op));
+                            break;
         case RELAT_OP:  fprintf(stdout, "[%s]", RELOPtostring(v.u.rop)); break;
+        case LOCAL:     fprintf(stdout, "[%s]", v.u.local->name); break;
+        case FUNCTION:  fprintf(stdout, "[%s]", v.u.fn->name); break;
+        case BUILTIN:   fprintf(stdout, "[%s]", v.u.builtin->name); break;
         case NONE:      fprintf(stdout, "[%s]", NONE_S);
         case INVALID:   fprintf(stdout, "[%s]", INVALID_S);
     }
@@ -181,7 +269,8 @@ double do_math(double lhs, OPERATOR op, double rhs)
         case EXP:   return pow(lhs, rhs);
         case LOG:   return log(lhs) / log(rhs);
         case MOD:   return fmod(lhs, rhs);
-        case INT:   return (int) lhs / (int) rhs;
+        // Adding zero turns a negative zero into the zero (int) casts gave
+        case INT:   return trunc(trunc(lhs) / trunc(rhs)) + 0.0;
         case PROD:  return lhs * rhs;
         case QUOT:  return lhs / rhs;
         case SUM:   return lhs + rhs;
@@ -191,6 +280,56 @@ double do_math(double lhs, OPERATOR op, double rhs)
     return 0;
 }
 
+/* Exact integer arithmetic. False when the result is not an integer that */
+/* fits, or would differ from do_math's, such as a negative zero          */
+bool do_integer_math(int64_t lhs, OPERATOR op, int64_t rhs, int64_t *result)
+{
+    switch (op) {
+        case SUM:   return !__builtin_add_overflow(lhs, rhs, result);
+        case DIFF:  return !__builtin_sub_overflow(lhs, rhs, result);
+        case PROD:
+            if (((lhs == 0) && (rhs < 0)) || ((rhs == 0) && (lhs < 0))) {
+                return false;
+            }
+            return !__builtin_mul_overflow(lhs, rhs, result);
+        case QUOT:
+            if ((rhs == 0) || (lhs == 0) ||
+                    ((lhs == INT64_MIN) && (rhs == -1)) || (lhs % rhs != 0)) {
+                return false;
+            }
+            *result = lhs / rhs;
+            return true;
+        case INT:
+            if ((rhs == 0) || ((lhs == INT64_MIN) && (rhs == -1))) {
+                return false;
+            }
+            *result = lhs / rhs;
+            return true;
+        case MOD:
+            if ((rhs == 0) || (rhs == -1)) return false;
+            *result = lhs % rhs;
+            return (*result != 0) || (lhs >= 0);
+        case EXP:   return integer_power(lhs, rhs, result);
+        default:    return false;
+    }
+}
+
+/* Exponentiation by squaring */
+bool integer_power(int64_t base, int64_t exp, int64_t *result)
+{
+    if (exp < 0) return false;
+
+    int64_t r = 1;
+    while (true) {
+        if ((exp & 1) && __builtin_mul_overflow(r, base, &r)) return false;
+        exp >>= 1;
+        if (exp == 0) break;
+        if (__builtin_mul_overflow(base, base, &base)) return false;
+    }
+    *result = r;
+    return true;
+}
+
 bool relate(double lhs, RELOP op, double rhs)
 {
     switch (op) {
@@ -205,6 +344,20 @@ bool relate(double lhs, RELOP op, double rhs)
     return false;
 }
 
+bool relate_integers(int64_t lhs, RELOP op, int64_t rhs)
+{
+    switch (op) {
+        case EQUAL: return lhs == rhs;
+        case NOT_EQUAL: return lhs != rhs;
+        case LESS_THAN: return lhs < rhs;
+        case GREATER_THAN: return lhs > rhs;
+        case LESS_THAN_OR_EQUAL: return lhs <= rhs;
+        case GREATER_THAN_OR_EQUAL: return lhs >= rhs;
+    }
+    // Compiler dummy
+    return false;
+}
+
 bool cmp_strings(char *lhs, RELOP op, char *rhs)
 {
     switch (op) {
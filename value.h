@@ -5,38 +5,67 @@
 #include "relop.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum Type {
     INVALID = -2, NONE = -1, NUMBER, STRING, VAR, BOOL,
-    OP, RELAT_OP
+    OP, RELAT_OP, LOCAL, FUNCTION, BUILTIN
 } Type;
 
 const char *typestring(Type t);
 bool is_literal_type(Type t);
 
+/* A name resolved at parse time to a slot in an enclosing frame. depth
+ * counts frames outwards from the innermost one */
+typedef struct Local {
+    char *name;
+    unsigned depth;
+    unsigned slot;
+} Local;
+
+/* See function.h and builtin.h */
+struct Function;
+struct Builtin;
+
+/* A NUMBER is held exactly in i while it is integral and fits, and in d
+ * otherwise. Arithmetic on two integral numbers stays integral unless the
+ * result would not be exact */
 typedef struct Value {
     Type type;
+    bool integral;
     union {
         double d;
+        int64_t i;
         char  *s;
         char  *name;
         OPERATOR op;
         RELOP rop;
         bool b;
+        Local *local;
+        struct Function *fn;
+        const struct Builtin *builtin;
     } u;
 } Value;
 
-static const Value NOTHING = {NONE, {0}};
+static const Value NOTHING = {NONE, false, {0}};
 
 Value Value_new_number(double d);
+Value Value_new_integer(int64_t i);
 Value Value_new_string(const char *s);
 Value Value_new_op(OPERATOR op);
 Value Value_new_var(char *name);
 Value Value_new_bool(bool b);
 Value Value_new_relop(RELOP r);
+Value Value_new_local(char *name, unsigned depth, unsigned slot);
+/* Takes over the caller's hold on fn */
+Value Value_new_function(struct Function *fn);
+Value Value_new_builtin(const struct Builtin *b);
 
 Value Value_copy(Value v);
 
+/* The value of a NUMBER as a double, however it is held */
+double Value_number(Value v);
+
 void Value_free(Value *v);
 
 Value Value_combine(Value lhs, OPERATOR op, Value rhs);